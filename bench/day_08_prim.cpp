@@ -0,0 +1,68 @@
+// The day's solvers without its main(), so the engines can be called directly
+#define AOC_RUNNER
+#include "day_08.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Dense Prim engines of day_08 on random boxes, 10k to 200k of them, against
+// the k-d tree Kruskal. "small" coordinates are like the puzzle's (squared
+// distances fit a double exactly, so the AVX2 kernel runs), "large" ones
+// span the whole int range and take the 128-bit integer path. The rate is
+// over all n(n-1)/2 pairs, even for the k-d tree, which skips most of them.
+//
+// Usage: bench/day_08_prim [MAX_BOXES]   (200k by default, a few minutes)
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<day_08::Box> random_boxes(size_t n, int range) {
+  std::mt19937 rng(n);
+  std::uniform_int_distribution<int> coord(-range, range);
+  std::vector<day_08::Box> boxes(n);
+  for (auto &b : boxes)
+    b = {coord(rng), coord(rng), coord(rng)};
+  return boxes;
+}
+
+// Runs the engine and prints its time, pairs per second and answer
+template <typename F> void report(const char *name, size_t n, F f) {
+  std::ostringstream answer;
+  auto start = Clock::now();
+  {
+    aoc::io::OutputRedirect redirect(answer);
+    f();
+  }
+  double s = std::chrono::duration<double>(Clock::now() - start).count();
+  std::string line = answer.str();
+  if (!line.empty() && line.back() == '\n')
+    line.pop_back();
+  std::printf("  %-12s %9.3f s  %7.2f Gpairs/s  (%s)\n", name, s,
+              day_08::row_offset(n, n) / s / 1e9, line.c_str());
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t max_n = argc > 1 ? std::stoul(argv[1]) : 200'000;
+
+  for (size_t n : {10'000, 25'000, 50'000, 100'000, 200'000}) {
+    if (n > max_n)
+      break;
+    auto small = random_boxes(n, 100'000);
+    auto large = random_boxes(n, 2'000'000'000);
+
+    std::printf("%zu boxes\n", n);
+    report("prim", n, [&] { day_08::solve_prim(small, true); });
+    report("prim-scalar", n, [&] { day_08::solve_prim(small, false); });
+    report("kdtree", n, [&] { day_08::solve_kdtree(small); });
+    report("prim large", n, [&] { day_08::solve_prim(large, true); });
+  }
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+#include "shared/disjoint_set.hpp"
+#include "shared/parallel.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Find/unite throughput of aoc::DisjointSet against the recursive union-find
+// day_08 used before (separate parent and size arrays, full path compression),
+// and of aoc::ConcurrentDisjointSet on one thread and on every core.
+//
+// Usage: bench/disjoint_set [NODES]   (4M by default)
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Recursive {
+  std::vector<int> parent, sz;
+
+  explicit Recursive(size_t n) : parent(n), sz(n, 1) {
+    for (size_t i = 0; i < n; ++i)
+      parent[i] = i;
+  }
+
+  int find(int i) {
+    if (parent[i] == i)
+      return i;
+    return parent[i] = find(parent[i]);
+  }
+
+  bool unite(int i, int j) {
+    i = find(i);
+    j = find(j);
+    if (i == j)
+      return false;
+    if (sz[i] < sz[j])
+      std::swap(i, j);
+    parent[j] = i;
+    sz[i] += sz[j];
+    return true;
+  }
+};
+
+// Runs f() and prints millions of operations per second
+template <typename F> void report(const char *name, size_t ops, F f) {
+  auto start = Clock::now();
+  size_t check = f();
+  double s = std::chrono::duration<double>(Clock::now() - start).count();
+  std::printf("  %-28s %8.1f Mops/s  (%zu)\n", name, ops / s / 1e6, check);
+}
+
+// Unites n random pairs, then finds n random nodes
+template <typename Set>
+void random_edges(const char *name, size_t n, const std::vector<int> &u,
+                  const std::vector<int> &v) {
+  report(name, 2 * n, [&] {
+    Set set(n);
+    size_t joined = 0;
+    for (size_t i = 0; i < n; ++i)
+      joined += set.unite(u[i], v[i]);
+    for (size_t i = 0; i < n; ++i)
+      joined += set.find(v[i]) == set.find(u[i]);
+    return joined;
+  });
+}
+
+// The same on every core: each thread unites, then finds, its slice of the
+// pairs
+void concurrent_edges(const char *name, size_t n, int threads,
+                      const std::vector<int> &u, const std::vector<int> &v) {
+  report(name, 2 * n, [&] {
+    aoc::ConcurrentDisjointSet set(n);
+    std::atomic<size_t> joined{0};
+    auto slice = [&](int t, auto f) {
+      size_t count = 0;
+      for (size_t i = n * t / threads; i < n * (t + 1) / threads; ++i)
+        count += f(i);
+      joined += count;
+    };
+    aoc::run_threads(threads, [&](int t) {
+      slice(t, [&](size_t i) { return set.unite(u[i], v[i]); });
+    });
+    aoc::run_threads(threads, [&](int t) {
+      slice(t, [&](size_t i) { return set.find(v[i]) == set.find(u[i]); });
+    });
+    return joined.load();
+  });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? std::stoul(argv[1]) : 4'000'000;
+
+  std::mt19937 rng(2025);
+  std::uniform_int_distribution<int> node(0, n - 1);
+  std::vector<int> u(n), v(n);
+  for (size_t i = 0; i < n; ++i) {
+    u[i] = node(rng);
+    v[i] = node(rng);
+  }
+
+  std::printf("%zu nodes, random edges\n", n);
+  random_edges<Recursive>("recursive, two arrays", n, u, v);
+  random_edges<aoc::DisjointSet>("aoc::DisjointSet", n, u, v);
+  random_edges<aoc::ConcurrentDisjointSet>("ConcurrentDisjointSet", n, u, v);
+  int threads = aoc::thread_count();
+  std::string name = "ConcurrentDisjointSet x" + std::to_string(threads);
+  concurrent_edges(name.c_str(), n, threads, u, v);
+
+  // Neighbours joined in order, like a chain of boxes: one set growing by a
+  // node at a time
+  std::printf("%zu nodes, unite(i - 1, i) then find every node\n", n);
+  report("recursive, two arrays", 2 * n, [&] {
+    Recursive set(n);
+    size_t same = 0;
+    for (size_t i = 1; i < n; ++i)
+      set.unite(i - 1, i);
+    for (size_t i = 0; i < n; ++i)
+      same += set.find(i) == set.find(0);
+    return same;
+  });
+  report("aoc::DisjointSet", 2 * n, [&] {
+    aoc::DisjointSet set(n);
+    size_t same = 0;
+    for (size_t i = 1; i < n; ++i)
+      set.unite(i - 1, i);
+    for (size_t i = 0; i < n; ++i)
+      same += set.find(i) == set.find(0);
+    return same;
+  });
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include "shared/io.hpp"
+#include "shared/registry.hpp"
+#include "shared/thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Runs several days in one process, all at once on a shared work-stealing
+// pool. Days that parallelise internally (aoc::run_threads) queue their work
+// on the same pool, so the whole set keeps every core busy without
+// oversubscribing it.
+//
+// Usage: aoc_runner [-j THREADS] [-i INPUT_DIR] [DAY...]
+// Reads INPUT_DIR/day_XX.txt ("inputs" by default) for every DAY, or for
+// every registered day if none are given.
+
+using Clock = std::chrono::steady_clock;
+
+struct Run {
+  int day;
+  aoc::Solver solve;
+  std::string path;
+  std::ostringstream output;
+  bool found = false;
+  std::string error; // what the day threw, if it did
+  double load_ms = 0, solve_ms = 0;
+};
+
+double ms_since(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+void run_day(Run &run) {
+  auto start = Clock::now();
+  aoc::io::MappedFile input(run.path);
+  if (!input)
+    return;
+  // Touch the pages now, so the mmap faults count as load time rather than
+  // solve time
+  volatile char sink = 0;
+  for (size_t i = 0; i < input.view().size(); i += 4096)
+    sink = sink + input.view()[i];
+  run.found = true;
+  run.load_ms = ms_since(start);
+
+  start = Clock::now();
+  aoc::io::OutputRedirect redirect(run.output);
+  // A day failing (on a malformed input, say) shouldn't take the others down
+  try {
+    run.solve(input.view());
+  } catch (const std::exception &e) {
+    run.error = e.what();
+  } catch (...) {
+    run.error = "unknown exception";
+  }
+  run.solve_ms = ms_since(start);
+}
+
+int main(int argc, char **argv) {
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  std::string input_dir = "inputs";
+  std::vector<int> days;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "-j" && i + 1 < argc)
+      threads = std::max(1, std::stoi(argv[++i]));
+    else if (arg == "-i" && i + 1 < argc)
+      input_dir = argv[++i];
+    else
+      days.push_back(std::stoi(argv[i]));
+  }
+
+  const auto &registered = aoc::registered_days();
+  if (days.empty())
+    for (const auto &[day, solve] : registered)
+      days.push_back(day);
+
+  std::vector<std::unique_ptr<Run>> runs;
+  for (int day : days) {
+    auto it = registered.find(day);
+    if (it == registered.end()) {
+      std::cerr << "Unknown day: " << day << std::endl;
+      return 1;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "/day_%02d.txt", day);
+    runs.push_back(std::make_unique<Run>());
+    runs.back()->day = day;
+    runs.back()->solve = it->second;
+    runs.back()->path = input_dir + name;
+  }
+
+  auto start = Clock::now();
+  {
+    aoc::ThreadPool pool(threads);
+    aoc::TaskGroup group(pool);
+    for (auto &run : runs)
+      group.run([&run] { run_day(*run); });
+    group.wait();
+  }
+  double total_ms = ms_since(start);
+
+  bool failed = false;
+  for (const auto &run : runs) {
+    std::printf("Day %02d", run->day);
+    if (!run->found) {
+      std::printf("  no input at %s\n", run->path.c_str());
+      continue;
+    }
+    if (!run->error.empty()) {
+      std::printf("  failed: %s\n", run->error.c_str());
+      failed = true;
+      continue;
+    }
+    std::printf("  load %8.3f ms  solve %9.3f ms\n", run->load_ms,
+                run->solve_ms);
+    std::fputs(run->output.str().c_str(), stdout);
+  }
+  std::printf("Total %.3f ms on %d threads\n", total_ms, threads);
+
+  return failed ? 1 : 0;
+}
@@ -1,36 +1,58 @@
+#include "shared/alloc.hpp"
+#include "shared/cache.hpp"
 #include "shared/io.hpp"
+#include "shared/perf.hpp"
+#include "shared/pipeline.hpp"
+#include "shared/registry.hpp"
+#include <charconv>
+#include <cstdlib>
 #include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
-void part1(const std::vector<std::string> &lines) {
+namespace day_01 {
+
+// "L68" -> -68, "R48" -> 48
+int parse_rotation(std::string_view line) {
+  int steps = 0;
+  std::from_chars(line.data() + 1, line.data() + line.size(), steps);
+  return line[0] == 'L' ? -steps : steps;
+}
+
+// Each rotation as a signed number of steps
+std::vector<int> parse_rotations(const std::vector<std::string> &lines) {
+  std::vector<int> rotations;
+  for (const auto &line : lines)
+    rotations.push_back(parse_rotation(line));
+  return rotations;
+}
+
+// Both parts one rotation at a time, so they can also run on a stream
+struct Part1 {
   int ans = 0;
   int starting_pos = 50;
 
-  for (const auto &line : lines) {
+  void rotate(int rotation) {
     // it's a circular sum!
-    if (line[0] == 'L') {
-      starting_pos -= std::stoi(line.substr(1));
-      starting_pos %= 100;
-    } else {
-      starting_pos += std::stoi(line.substr(1));
-      starting_pos %= 100;
-    }
+    starting_pos += rotation;
+    starting_pos %= 100;
     if (starting_pos == 0) {
       ans++;
     }
-    std::cout << "Current position: " << starting_pos << std::endl;
+    aoc::io::out() << "Current position: " << starting_pos << std::endl;
   }
-  std::cout << ans << std::endl;
-}
+};
 
-void part2(const std::vector<std::string> &lines) {
+struct Part2 {
   int ans = 0;
   int starting_pos = 50;
 
-  for (const auto &line : lines) {
-    int steps = std::stoi(line.substr(1));
+  void rotate(int rotation) {
+    int steps = std::abs(rotation);
 
-    if (line[0] == 'L') {
+    if (rotation < 0) {
       for (int i = 0; i < steps; i++) {
         starting_pos--;
         if (starting_pos == 0) {
@@ -49,17 +71,79 @@ void part2(const std::vector<std::string> &lines) {
       }
     }
   }
-  std::cout << ans << std::endl;
+};
+
+void part1(std::span<const int> rotations) {
+  AOC_PERF_SCOPE("day_01 part1", rotations.size());
+  Part1 dial;
+  for (int rotation : rotations)
+    dial.rotate(rotation);
+  aoc::io::out() << dial.ans << std::endl;
+}
+
+void part2(std::span<const int> rotations) {
+  AOC_PERF_SCOPE("day_01 part2", rotations.size());
+  Part2 dial;
+  for (int rotation : rotations)
+    dial.rotate(rotation);
+  aoc::io::out() << dial.ans << std::endl;
 }
 
-int main() {
-  auto lines = aoc::io::read_lines();
+// Streaming engine: every line is parsed and fed to both parts while the
+// reader thread fetches the rest of stdin
+void solve_stream() {
+  Part1 p1;
+  Part2 p2;
+  aoc::io::for_each_line([&](std::string_view line) {
+    int rotation = parse_rotation(line);
+    p1.rotate(rotation);
+    p2.rotate(rotation);
+  });
+  aoc::io::out() << p1.ans << std::endl;
+  aoc::io::out() << p2.ans << std::endl;
+}
+
+// Entry point for the multi-day runner: default engine, no cache
+void solve(std::string_view input) {
+  auto rotations = parse_rotations(aoc::io::split_lines(input));
+  part1(rotations);
+  part2(rotations);
+}
+
+[[maybe_unused]] const bool registered = aoc::register_day(1, solve);
+
+} // namespace day_01
+
+#ifndef AOC_RUNNER
+int main(int argc, char **argv) {
+  using namespace day_01;
+
+  // Optional: "stream" parses and solves while stdin is still being read
+  if (argc > 1 && std::string_view(argv[1]) == "stream") {
+    AOC_ALLOC_PHASE("stream");
+    solve_stream();
+    return 0;
+  }
+
+  auto store = aoc::cache::Store::open("day_01 rotations v1");
+  std::vector<int> rotations;
+  if (!store.hit()) {
+    AOC_ALLOC_PHASE("read");
+    auto lines = aoc::io::read_lines();
+    AOC_ALLOC_PHASE("parse");
+    rotations = parse_rotations(lines);
+    store.put(rotations);
+    store.save();
+  }
 
-  part1(lines);
-  part2(lines);
+  AOC_ALLOC_PHASE("part1");
+  part1(store.get<int>(0));
+  AOC_ALLOC_PHASE("part2");
+  part2(store.get<int>(0));
 
   return 0;
 }
+#endif
 
 /** Notes
  *
@@ -1,9 +1,21 @@
+#include "shared/alloc.hpp"
+#include "shared/cache.hpp"
 #include "shared/io.hpp"
+#include "shared/parallel.hpp"
+#include "shared/perf.hpp"
+#include "shared/registry.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+namespace day_02 {
+
 struct Range {
   long long start;
   long long end;
@@ -43,19 +55,115 @@ bool is_invalid(long long number) {
   return false;
 }
 
-void solve(const std::vector<Range> &ranges) {
+// Number of ids the brute force has to check
+uint64_t id_count(std::span<const Range> ranges) {
+  uint64_t n = 0;
+  for (const auto &r : ranges)
+    n += r.end - r.start + 1;
+  return n;
+}
+
+void solve(std::span<const Range> ranges) {
+  AOC_PERF_SCOPE("day_02 is_invalid", id_count(ranges));
   long long ans = 0;
   for (const auto &r : ranges) {
     for (long long i = r.start; i <= r.end; i++)
       if (is_invalid(i))
         ans += i;
   }
-  std::cout << ans << std::endl;
+  aoc::io::out() << ans << std::endl;
+}
+
+// Every invalid id with up to INDEX_DIGITS digits, sorted, plus prefix sums
+// (prefix[i] is the sum of ids[0..i)). The sum of all of them still fits in a
+// long long at 12 digits, at 14 it wouldn't anymore.
+constexpr int INDEX_DIGITS = 12;
+constexpr long long INDEX_LIMIT = 1000000000000LL; // 10^INDEX_DIGITS
+constexpr std::string_view INDEX_TAG = "day_02 invalid ids v1";
+
+struct InvalidIndex {
+  std::span<const long long> ids;
+  std::span<const long long> prefix;
+
+  bool covers(const Range &r) const { return r.end < INDEX_LIMIT; }
+
+  // Sum of the invalid ids in r, r has to be covered
+  long long sum(const Range &r) const {
+    size_t lo = std::lower_bound(ids.begin(), ids.end(), r.start) - ids.begin();
+    size_t hi = std::upper_bound(ids.begin(), ids.end(), r.end) - ids.begin();
+    return lo < hi ? prefix[hi] - prefix[lo] : 0;
+  }
+};
+
+// An id with d digits made of a k digit seed repeated d / k times is
+// seed * (10^(d-k) + ... + 10^k + 1). Ids with several periods (111111) come
+// out more than once, hence the unique.
+std::vector<long long> build_invalid_ids() {
+  std::vector<long long> ids;
+  long long pow10[INDEX_DIGITS + 1] = {1};
+  for (int i = 1; i <= INDEX_DIGITS; i++)
+    pow10[i] = pow10[i - 1] * 10;
+
+  for (int d = 2; d <= INDEX_DIGITS; d++) {
+    for (int k = 1; k <= d / 2; k++) {
+      if (d % k != 0)
+        continue;
+      long long repeat = (pow10[d] - 1) / (pow10[k] - 1);
+      for (long long seed = pow10[k - 1]; seed < pow10[k]; seed++)
+        ids.push_back(seed * repeat);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  return ids;
+}
+
+std::vector<long long> prefix_sums(std::span<const long long> ids) {
+  std::vector<long long> prefix(ids.size() + 1, 0);
+  for (size_t i = 0; i < ids.size(); i++)
+    prefix[i + 1] = prefix[i] + ids[i];
+  return prefix;
 }
 
-int main() {
-  auto lines = aoc::io::read_lines();
+// Sums of a batch of ranges, split in contiguous chunks over the threads.
+// Ranges past the index fall back to checking every id.
+std::vector<long long> range_sums(const InvalidIndex &index,
+                                  std::span<const Range> ranges) {
+  AOC_PERF_SCOPE("day_02 range_sums", ranges.size());
+  std::vector<long long> sums(ranges.size());
+  int threads = ranges.size() < 4096 ? 1 : aoc::thread_count();
+  size_t chunk = (ranges.size() + threads - 1) / threads;
+  aoc::run_threads(threads, [&](int t) {
+    size_t begin = std::min(ranges.size(), t * chunk);
+    size_t end = std::min(ranges.size(), begin + chunk);
+    for (size_t i = begin; i < end; i++) {
+      const Range &r = ranges[i];
+      if (index.covers(r)) {
+        sums[i] = index.sum(r);
+        continue;
+      }
+      sums[i] = 0;
+      for (long long id = r.start; id <= r.end; id++)
+        if (is_invalid(id))
+          sums[i] += id;
+    }
+  });
+  return sums;
+}
+
+void solve_indexed(const InvalidIndex &index, std::span<const Range> ranges,
+                   bool each) {
+  auto sums = range_sums(index, ranges);
+  long long ans = 0;
+  for (long long s : sums) {
+    ans += s;
+    if (each)
+      aoc::io::out() << s << '\n';
+  }
+  aoc::io::out() << ans << std::endl;
+}
 
+std::vector<Range> parse_ranges(const std::vector<std::string> &lines) {
   std::vector<Range> ranges;
   std::string line = lines[0];
   std::stringstream ss(line);
@@ -65,11 +173,77 @@ int main() {
     ranges.push_back({std::stoll(range.substr(0, range.find('-'))),
                       std::stoll(range.substr(range.find('-') + 1))});
   }
+  return ranges;
+}
+
+// Entry point for the multi-day runner: default engine, no cache
+void solve(std::string_view input) {
+  solve(parse_ranges(aoc::io::split_lines(input)));
+}
+
+[[maybe_unused]] const bool registered = aoc::register_day(2, solve);
+
+} // namespace day_02
+
+#ifndef AOC_RUNNER
+int main(int argc, char **argv) {
+  using namespace day_02;
+
+  // Optional flags:
+  //   index       answer every range from the sorted index of invalid ids
+  //   index FILE  same, with the index kept in FILE (built there on first use)
+  //   each        with index, print the sum of every range before the total
+  bool indexed = false, each = false;
+  std::string index_path;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "index") {
+      indexed = true;
+      if (i + 1 < argc && std::string_view(argv[i + 1]) != "each")
+        index_path = argv[++i];
+    } else if (arg == "each") {
+      each = true;
+    }
+  }
+
+  auto store = aoc::cache::Store::open("day_02 ranges v1");
+  std::vector<Range> ranges;
+  if (!store.hit()) {
+    AOC_ALLOC_PHASE("read");
+    auto lines = aoc::io::read_lines();
+    AOC_ALLOC_PHASE("parse");
+    ranges = parse_ranges(lines);
+    store.put(ranges);
+    store.save();
+  }
+
+  if (indexed) {
+    AOC_ALLOC_PHASE("index");
+    // Without a file the store is never hit and save() does nothing
+    auto index_store = aoc::cache::Store::open_file(index_path, INDEX_TAG);
+    std::vector<long long> ids, prefix;
+    if (!index_store.hit()) {
+      AOC_PERF_SCOPE("day_02 build index", 0);
+      ids = build_invalid_ids();
+      prefix = prefix_sums(ids);
+      index_store.put(ids);
+      index_store.put(prefix);
+      if (!index_store.save())
+        std::cerr << "Could not write index file: " << index_path << std::endl;
+    }
+    InvalidIndex index{index_store.get<long long>(0),
+                       index_store.get<long long>(1)};
+    AOC_ALLOC_PHASE("solve");
+    solve_indexed(index, store.get<Range>(0), each);
+    return 0;
+  }
 
-  solve(ranges);
+  AOC_ALLOC_PHASE("solve");
+  solve(store.get<Range>(0));
 
   return 0;
 }
+#endif
 
 /** Notes
  *
@@ -116,4 +290,19 @@ int main() {
  * contain a repeated character.
  * SC: O(1) -> we only need to store the sum of
  * the invalid ids.
+ *
+ * That's still every id in every range. With lots of ranges it's better to
+ * turn it around and list the invalid ids instead: a d digit one is a k digit
+ * seed times 10^(d-k) + ... + 10^k + 1, for every k dividing d. There are far
+ * fewer of them than ids (about a million up to 10^12), so we can sort them
+ * once, keep prefix sums next to them and answer a range with two binary
+ * searches and a subtraction. The index is the same for every input, so it
+ * can live in a file and be mapped back instead of rebuilt.
+ *
+ * The index stops at 12 digits: at 18 there would be around a billion ids, and
+ * the prefix sums would overflow a long long past 12 anyway. Ranges going
+ * beyond that still go through the brute force.
+ *
+ * TC: O(I log I) once to build it (I ids), then O(log I) per range
+ * SC: O(I)
  */
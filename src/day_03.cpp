@@ -1,8 +1,22 @@
+#include "shared/alloc.hpp"
 #include "shared/io.hpp"
+#include "shared/perf.hpp"
+#include "shared/pipeline.hpp"
+#include "shared/registry.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <span>
+#include <string>
 #include <string_view>
 #include <vector>
 
+namespace day_03 {
+
+// 20 digits don't fit in 64 bits
+using aoc::u128;
+using aoc::io::to_string;
+
 long long solve_line(const std::string_view line, size_t n) {
   std::string stack;
   stack.reserve(n);
@@ -24,20 +38,137 @@ long long solve_line(const std::string_view line, size_t n) {
 }
 
 void solve(const std::vector<std::string> &lines) {
+  AOC_PERF_SCOPE("day_03 solve_line", aoc::perf::total_size(lines));
   long long ans = 0;
 
   for (auto &line : lines) {
     ans += solve_line(line, 12);
   }
-  std::cout << ans << std::endl;
+  aoc::io::out() << ans << std::endl;
+}
+
+// Streaming engine: each bank is solved as soon as its line has been read
+void solve_stream() {
+  long long ans = 0;
+  aoc::io::for_each_line(
+      [&](std::string_view line) { ans += solve_line(line, 12); });
+  aoc::io::out() << ans << std::endl;
 }
 
-int main() {
+/**
+ * Where the next occurrence of each digit is in a bank, so the greedy pick for
+ * any N doesn't need to scan the bank again.
+ */
+class BankIndex {
+public:
+  void build(std::string_view bank) {
+    len = bank.size();
+    next.resize((len + 1) * 10);
+    std::fill_n(next.begin() + len * 10, 10, uint32_t(len));
+    for (size_t i = len; i-- > 0;) {
+      std::copy_n(next.begin() + (i + 1) * 10, 10, next.begin() + i * 10);
+      next[i * 10 + (bank[i] - '0')] = i;
+    }
+  }
+
+  // Largest number made of n digits of the bank, kept in order
+  u128 best(size_t n) const {
+    n = std::min(n, len);
+    u128 value = 0;
+    size_t pos = 0;
+    for (size_t picked = 0; picked < n; picked++) {
+      // Leave enough digits after this one for the rest of the pick
+      size_t last = len - (n - picked);
+      const uint32_t *at = &next[pos * 10];
+      int d = 9;
+      while (at[d] > last)
+        d--;
+      value = value * 10 + d;
+      pos = at[d] + 1;
+    }
+    return value;
+  }
+
+private:
+  size_t len = 0;
+  std::vector<uint32_t> next; // next[i * 10 + d]: first d at or after i
+};
+
+/**
+ * Best joltage of every bank for every n in ns: the answer for bank b and
+ * ns[j] is at b * ns.size() + j.
+ */
+std::vector<u128> best_joltages(const std::vector<std::string> &lines,
+                                std::span<const int> ns) {
+  AOC_PERF_SCOPE("day_03 best_joltages", aoc::perf::total_size(lines));
+  std::vector<u128> best;
+  best.reserve(lines.size() * ns.size());
+  BankIndex index;
+  for (const auto &line : lines) {
+    index.build(line);
+    for (int n : ns)
+      best.push_back(index.best(n));
+  }
+  return best;
+}
+
+// Total joltage over all banks for each n, one "n total" line each
+void solve_multi(const std::vector<std::string> &lines,
+                 std::span<const int> ns) {
+  auto best = best_joltages(lines, ns);
+  for (size_t j = 0; j < ns.size(); j++) {
+    u128 total = 0;
+    for (size_t b = 0; b < lines.size(); b++)
+      total += best[b * ns.size() + j];
+    aoc::io::out() << ns[j] << ' ' << to_string(total) << '\n';
+  }
+  aoc::io::out() << std::flush;
+}
+
+// Entry point for the multi-day runner: default engine, no cache
+void solve(std::string_view input) {
+  solve(aoc::io::split_lines(input));
+}
+
+[[maybe_unused]] const bool registered = aoc::register_day(3, solve);
+
+} // namespace day_03
+
+#ifndef AOC_RUNNER
+int main(int argc, char **argv) {
+  using namespace day_03;
+
+  // Optional: "n" followed by pick counts (N or A-B) prints the total for
+  // each of them instead of the part 2 answer, e.g. "n 2-20". "stream"
+  // solves the banks while stdin is still being read.
+  if (argc > 1 && std::string_view(argv[1]) == "stream") {
+    AOC_ALLOC_PHASE("stream");
+    solve_stream();
+    return 0;
+  }
+
+  std::vector<int> ns;
+  for (int i = 2; i < argc && std::string_view(argv[1]) == "n"; ++i) {
+    std::string_view arg = argv[i];
+    size_t dash = arg.find('-');
+    int from = std::stoi(std::string(arg.substr(0, dash)));
+    int to = dash == arg.npos ? from
+                              : std::stoi(std::string(arg.substr(dash + 1)));
+    for (int n = from; n <= to; n++)
+      ns.push_back(n);
+  }
+
+  AOC_ALLOC_PHASE("read");
   auto lines = aoc::io::read_lines();
-  solve(lines);
+  AOC_ALLOC_PHASE("solve");
+  if (ns.empty())
+    solve(lines);
+  else
+    solve_multi(lines, ns);
 
   return 0;
 }
+#endif
 
 /** Notes
  * The batteries are arranged into banks; each line of digits in the input
@@ -71,4 +202,14 @@ int main() {
  *
  * TC: O(n) -> same as above
  * SC: O(n) -> the stack grows like the string
+ *
+ * If we want the answer for many N (2 to 20, say) the stack runs again for
+ * each of them. The same greedy can be read the other way around: the first
+ * digit is the largest one that still leaves N - 1 digits after it (leftmost
+ * if tied), the next one the largest after that, and so on. With a table of
+ * where the next 0..9 is from every position, each pick is at most 10 lookups,
+ * and the table doesn't depend on N, so we build it once per bank.
+ *
+ * TC: O(n) per bank to build, then O(N) per query
+ * SC: O(10 n)
  */
@@ -1,13 +1,26 @@
+#include "shared/alloc.hpp"
+#include "shared/arena.hpp"
 #include "shared/io.hpp"
+#include "shared/perf.hpp"
+#include "shared/registry.hpp"
 #include <array>
+#include <cstdint>
+#include <deque>
 #include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <queue>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+namespace day_04 {
+
 constexpr std::array<std::pair<int, int>, 8> dirs = {
     {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}}};
 
-int count_neighbours(const std::vector<std::string> &grid, int r, int c) {
+int count_neighbours(const aoc::io::Lines &grid, int r, int c) {
   int count = 0;
   for (auto &[dr, dc] : dirs) {
     size_t nr = r + dr;
@@ -20,9 +33,10 @@ int count_neighbours(const std::vector<std::string> &grid, int r, int c) {
   return count;
 }
 
-void part1(const std::vector<std::string> &grid) {
+void part1(const aoc::io::Lines &grid) {
   int rows = grid.size();
   int cols = grid[0].size();
+  AOC_PERF_SCOPE("day_04 count_neighbours", uint64_t(rows) * cols);
   int ans = 0;
 
   for (int r = 0; r < rows; r++) {
@@ -35,24 +49,28 @@ void part1(const std::vector<std::string> &grid) {
     }
   }
 
-  std::cout << ans << std::endl;
+  aoc::io::out() << ans << std::endl;
 }
 
-void part2(const std::vector<std::string> &grid) {
+void part2(const aoc::io::Lines &grid) {
   int rows = grid.size();
   int cols = grid[0].size();
+  AOC_PERF_SCOPE("day_04 peel", uint64_t(rows) * cols);
+  // The working copy, the counts and the queue all come from one arena,
+  // released in one go when we're done
+  aoc::Arena arena;
   // copy grid
-  auto working_grid = grid;
-  std::vector<std::vector<int>> counts(
-      rows, std::vector<int>(cols, 0)); // store neighbour counts
-  std::queue<std::pair<int, int>> q;    // queue;
+  aoc::io::Lines working_grid(grid.begin(), grid.end(), arena);
+  std::pmr::vector<int> counts(rows * cols, 0, arena); // neighbour counts
+  std::queue<std::pair<int, int>, std::pmr::deque<std::pair<int, int>>> q(
+      arena.resource()); // queue;
 
   for (int r = 0; r < rows; r++) {
     for (int c = 0; c < cols; c++) {
       if (working_grid[r][c] != '@')
         continue;
-      counts[r][c] = count_neighbours(grid, r, c);
-      if (counts[r][c] < 4)
+      counts[r * cols + c] = count_neighbours(grid, r, c);
+      if (counts[r * cols + c] < 4)
         q.push({r, c});
     }
   }
@@ -76,23 +94,261 @@ void part2(const std::vector<std::string> &grid) {
 
       if (nr >= 0 && nr < rows && nc >= 0 && nc < cols) {
         if (working_grid[nr][nc] == '@') {
-          counts[nr][nc]--;
-          if (counts[nr][nc] < 4)
+          counts[nr * cols + nc]--;
+          if (counts[nr * cols + nc] < 4)
             q.push({nr, nc});
         }
       }
     }
   }
-  std::cout << ans << std::endl;
+  aoc::io::out() << ans << std::endl;
+}
+
+// Incremental engine: keeps both answers up to date while rolls are added and
+// removed.
+// Part 1 only needs the neighbour counts: an edit touches 9 cells.
+// Part 2: the rolls left after peeling are the largest set in which every
+// roll has at least 4 neighbours in the set, and that set doesn't depend on
+// the order of the peeling. So we keep a valid peeling order instead of
+// peeling again: every roll has a rank, its position in the order (KEPT for
+// the ones that stay), and a support, the number of neighbours ranked at or
+// after it. Invariant: support < 4 for removed rolls, >= 4 for kept ones.
+//  - clear: neighbours ranked before lose support; kept ones falling under 4
+//    are peeled (appended at the end of the order) and so on.
+//  - set: ranked first, the new roll counts for nobody, so if it has < 4
+//    neighbours nothing else changes. Otherwise it's tentatively kept, which
+//    can push removed neighbours to a support of 4: those are tentatively
+//    kept as well, and so on. Then the tentative ones are peeled again
+//    (appended at the end) and the survivors join the kept set.
+// Both only visit rolls whose support actually crosses 4, not a whole region.
+// The grid is padded by one empty cell on each side, so neighbours are fixed
+// index offsets with no bounds checks.
+class RollGrid {
+public:
+  explicit RollGrid(const aoc::io::Lines &grid)
+      : rows(grid.size()), cols(grid.empty() ? 0 : grid[0].size()),
+        width(cols + 2), roll((rows + 2) * width, 0), count(roll.size(), 0),
+        rank(roll.size(), 0), support(roll.size(), 0) {
+    for (int d = 0; d < 8; ++d)
+      offsets[d] = dirs[d].first * width + dirs[d].second;
+
+    for (int r = 0; r < rows; ++r)
+      for (int c = 0; c < cols; ++c)
+        if (grid[r][c] == '@')
+          add_roll(index(r, c));
+
+    // Initial peel: everything is kept, then the usual BFS
+    std::vector<int> queue;
+    for (size_t i = 0; i < roll.size(); ++i) {
+      if (!roll[i])
+        continue;
+      rank[i] = KEPT;
+      support[i] = count[i];
+      kept_rolls++;
+      if (support[i] < 4)
+        queue.push_back(i);
+    }
+    peel(queue);
+  }
+
+  bool has(int r, int c) const { return in_bounds(r, c) && roll[index(r, c)]; }
+
+  // Adds a roll at (r, c). Returns false if there already was one.
+  bool set(int r, int c) {
+    if (!in_bounds(r, c) || roll[index(r, c)])
+      return false;
+    int i = index(r, c);
+    add_roll(i);
+    if (count[i] < 4) {
+      rank[i] = first_rank--;
+      support[i] = count[i];
+      return true;
+    }
+
+    std::vector<int> stack, tentative;
+    promote(i, std::numeric_limits<int64_t>::min(), stack, tentative);
+    while (!stack.empty()) {
+      int j = stack.back();
+      stack.pop_back();
+      promote(j, rank[j], stack, tentative);
+    }
+    std::vector<int> queue;
+    for (int j : tentative)
+      if (support[j] < 4)
+        queue.push_back(j);
+    peel(queue);
+    return true;
+  }
+
+  // Removes the roll at (r, c). Returns false if there was none.
+  bool clear(int r, int c) {
+    if (!in_bounds(r, c) || !roll[index(r, c)])
+      return false;
+    int i = index(r, c);
+    if (rank[i] == KEPT)
+      kept_rolls--;
+    std::vector<int> queue;
+    for (int d : offsets) {
+      int j = i + d;
+      // Only the neighbours ranked up to i counted it
+      if (roll[j] && rank[j] <= rank[i] && support[j]-- == 4 &&
+          rank[j] == KEPT)
+        queue.push_back(j);
+    }
+    remove_roll(i);
+    peel(queue);
+    return true;
+  }
+
+  size_t accessible() const { return accessible_rolls; } // part 1
+  size_t removable() const { return rolls - kept_rolls; } // part 2
+
+private:
+  static constexpr int64_t KEPT = std::numeric_limits<int64_t>::max();
+
+  int rows, cols, width;
+  int offsets[8];
+  std::vector<uint8_t> roll;
+  std::vector<uint8_t> count;   // neighbouring rolls
+  std::vector<int64_t> rank;    // position in the peeling order, or KEPT
+  std::vector<uint8_t> support; // neighbours ranked at or after this roll
+  int64_t next_rank = 1;        // end of the order
+  int64_t first_rank = 0;       // start of the order
+  size_t rolls = 0, accessible_rolls = 0, kept_rolls = 0;
+
+  bool in_bounds(int r, int c) const {
+    return r >= 0 && r < rows && c >= 0 && c < cols;
+  }
+  int index(int r, int c) const { return (r + 1) * width + (c + 1); }
+
+  void add_roll(int i) {
+    roll[i] = 1;
+    rolls++;
+    count[i] = 0;
+    for (int d : offsets) {
+      int j = i + d;
+      if (!roll[j])
+        continue;
+      count[i]++;
+      if (++count[j] == 4)
+        accessible_rolls--; // 3 -> 4: no longer accessible
+    }
+    if (count[i] < 4)
+      accessible_rolls++;
+  }
+
+  void remove_roll(int i) {
+    roll[i] = 0;
+    rolls--;
+    if (count[i] < 4)
+      accessible_rolls--;
+    for (int d : offsets) {
+      int j = i + d;
+      if (roll[j] && count[j]-- == 4)
+        accessible_rolls++; // 4 -> 3: now accessible
+    }
+  }
+
+  // Moves i from rank `old` to KEPT: the neighbours ranked after `old` start
+  // counting it. Removed ones reaching a support of 4 go on the stack.
+  void promote(int i, int64_t old, std::vector<int> &stack,
+               std::vector<int> &tentative) {
+    rank[i] = KEPT;
+    support[i] = 0;
+    kept_rolls++;
+    tentative.push_back(i);
+    for (int d : offsets) {
+      int j = i + d;
+      if (!roll[j] || j == i)
+        continue;
+      if (rank[j] == KEPT) {
+        support[i]++;
+        support[j]++;
+      } else if (rank[j] > old && ++support[j] == 4) {
+        stack.push_back(j);
+      }
+    }
+  }
+
+  // Peels kept rolls under 4 (and the ones they bring down) to the end of
+  // the order
+  void peel(std::vector<int> &queue) {
+    while (!queue.empty()) {
+      int i = queue.back();
+      queue.pop_back();
+      if (rank[i] != KEPT || support[i] >= 4)
+        continue;
+      rank[i] = next_rank++;
+      kept_rolls--;
+      for (int d : offsets) {
+        int j = i + d;
+        if (roll[j] && rank[j] == KEPT && support[j]-- == 4)
+          queue.push_back(j);
+      }
+    }
+  }
+};
+
+// Builds the engine, then toggles a roll at each (row, col) and prints both
+// answers after every edit
+void solve_incremental(const aoc::io::Lines &grid,
+                       std::span<const std::pair<int, int>> toggles) {
+  RollGrid engine = [&] {
+    AOC_PERF_SCOPE("day_04 incremental build", grid.size() * grid[0].size());
+    return RollGrid(grid);
+  }();
+  aoc::io::out() << engine.accessible() << std::endl;
+  aoc::io::out() << engine.removable() << std::endl;
+
+  for (const auto &[r, c] : toggles) {
+    AOC_PERF_SCOPE("day_04 edit", 1);
+    if (!engine.clear(r, c))
+      engine.set(r, c);
+    aoc::io::out() << engine.accessible() << ' ' << engine.removable()
+                   << std::endl;
+  }
 }
 
-int main() {
-  auto lines = aoc::io::read_lines();
+// Entry point for the multi-day runner: default engine, no cache
+void solve(std::string_view input) {
+  aoc::Arena arena;
+  auto lines = aoc::io::split_lines(input, arena);
   part1(lines);
   part2(lines);
+}
+
+[[maybe_unused]] const bool registered = aoc::register_day(4, solve);
+
+} // namespace day_04
+
+#ifndef AOC_RUNNER
+int main(int argc, char **argv) {
+  using namespace day_04;
+
+  // Optional: "incremental R1 C1 R2 C2 ..." answers with the incremental
+  // engine, then toggles the roll at each (R, C) and prints "part1 part2"
+  // after every edit.
+  bool incremental = argc > 1 && std::string_view(argv[1]) == "incremental";
+  std::vector<std::pair<int, int>> toggles;
+  for (int i = 2; incremental && i + 1 < argc; i += 2)
+    toggles.push_back({std::stoi(argv[i]), std::stoi(argv[i + 1])});
+
+  aoc::Arena arena;
+  AOC_ALLOC_PHASE("read");
+  auto lines = aoc::io::read_lines(arena);
+  if (incremental) {
+    AOC_ALLOC_PHASE("incremental");
+    solve_incremental(lines, toggles);
+    return 0;
+  }
+  AOC_ALLOC_PHASE("part1");
+  part1(lines);
+  AOC_ALLOC_PHASE("part2");
+  part2(lines);
 
   return 0;
 }
+#endif
 
 /** Notes
  *
@@ -112,4 +368,25 @@ int main() {
  *
  * TC: O(n*m) -> we need to traverse the grid once to build the counts matrix.
  * SC: O(n*m) -> we make a shadow grid to count the neighbours.
+ *
+ * Incremental version (RollGrid): when rolls are added and removed a few at a
+ * time, there's no need to start over. The rolls that survive the peeling are
+ * exactly the largest set where everyone has >= 4 neighbours inside the set
+ * (like a k-core in graphs), and it only changes locally:
+ * - part 1: keep the neighbour counts and the number of rolls under 4. An
+ *   edit touches 9 cells -> O(1).
+ * - removing a roll can only shrink the set: peel again starting from its
+ *   neighbours -> O(rolls that fall).
+ * - adding a roll can only grow the set. First try: BFS from the new roll
+ *   through the removed rolls with >= 4 neighbours and peel that region.
+ *   Correct, but on a dense random 1000x1000 grid that region is basically
+ *   all the removed rolls (400k+), so every insert costs ~10ms.
+ *   Better: remember the order the rolls were peeled in. A roll was peeled
+ *   because it had < 4 neighbours peeled after it (or kept). Adding a roll
+ *   only breaks that for the rolls whose "after" count goes up to 4, so only
+ *   those get pulled back (tentatively kept), which may break it for the
+ *   rolls peeled after them, and so on. Then peel the pulled back ones again
+ *   and put them at the end of the order -> O(rolls that cross 4).
+ *   If the new roll has < 4 neighbours, put it at the start of the order:
+ *   nobody counts it and nothing changes -> O(1).
  */
@@ -1,55 +1,95 @@
+#include "shared/alloc.hpp"
+#include "shared/cache.hpp"
 #include "shared/io.hpp"
+#include "shared/perf.hpp"
+#include "shared/parallel.hpp"
+#include "shared/pipeline.hpp"
+#include "shared/radix_sort.hpp"
+#include "shared/registry.hpp"
 #include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
 #include <iostream>
-#include <sstream>
+#include <span>
+#include <string_view>
+#include <utility>
 #include <vector>
 
-using Interval = std::pair<long long, long long>;
+namespace day_05 {
 
-struct Input {
+// Like std::pair<long long, long long>, but trivially copyable, so it can be
+// stored in the cache as-is
+struct Interval {
+  long long first;
+  long long second;
+  auto operator<=>(const Interval &) const = default;
+};
+
+struct ParsedInput {
   std::vector<Interval> ranges;
   std::vector<long long> ids;
 };
 
-Input parse_input(const std::vector<std::string> &lines) {
-  Input data;
-  std::istringstream iss;
+// What the parts work on: views, so they can point into the cache as well
+struct Input {
+  std::span<const Interval> ranges;
+  std::span<const long long> ids;
+};
+
+// A line is either a range "3-5" or an id "17". We can safely assume that
+// ranges are positive, so the only thing we need to check is the dash.
+bool parse_line(std::string_view line, Interval &range, long long &id) {
+  const char *first = line.data(), *last = line.data() + line.size();
+  auto [p, ec] = std::from_chars(first, last, range.first);
+  if (p != last && *p == '-') {
+    std::from_chars(p + 1, last, range.second);
+    return true;
+  }
+  id = range.first;
+  return false;
+}
+
+ParsedInput parse_input(const std::vector<std::string> &lines) {
+  ParsedInput data;
 
   for (const auto &line : lines) {
     if (line.empty())
       continue;
 
-    // We can safely assume that ranges are positive, so the only
-    // thing we need to check is if the line contains a dash
-    if (line.find('-') != std::string::npos) {
-      iss.clear();
-      iss.str(line);
-
-      long long start, end;
-      char dash;
-      if (iss >> start >> dash >> end) {
-        data.ranges.push_back({start, end});
-      }
-    } else
-      data.ids.push_back(std::stol(line));
+    Interval range;
+    long long id;
+    if (parse_line(line, range, id))
+      data.ranges.push_back(range);
+    else
+      data.ids.push_back(id);
   }
 
   return data;
 }
 
+// Sorts by start only, which is all the merge needs. Flipping the sign bit
+// keeps negative starts in order as unsigned keys.
+void sort_by_start(std::vector<Interval> &ranges) {
+  int threads = ranges.size() < (1 << 16) ? 1 : aoc::thread_count();
+  aoc::radix_sort(
+      ranges,
+      [](const Interval &r) { return uint64_t(r.first) ^ (uint64_t(1) << 63); },
+      threads);
+}
+
 std::vector<Interval> merge_intervals(std::vector<Interval> ranges) {
   if (ranges.empty())
     return {};
 
-  std::sort(ranges.begin(), ranges.end());
+  sort_by_start(ranges);
   std::vector<Interval> merged;
 
-  for (size_t i = 0; i < ranges.size(); i++) {
-    auto &cur = merged.back();
-    const auto &next = ranges[i];
-    if (merged.empty() || cur.second < next.first - 1) {
+  for (const auto &next : ranges) {
+    if (merged.empty() || merged.back().second < next.first - 1) {
       merged.push_back(next);
     } else {
+      auto &cur = merged.back();
       cur.second = std::max(cur.second, next.second);
     }
   }
@@ -57,46 +97,284 @@ std::vector<Interval> merge_intervals(std::vector<Interval> ranges) {
   return merged;
 }
 
+/**
+ * Merged ranges, compressed. They're cut into blocks of BLOCK ranges, and a
+ * block stores, for every range, its start as an offset from the first one
+ * and its length, bit-packed with the smallest widths that fit the whole
+ * block. The first start of every block goes in a separate sorted array, so a
+ * lookup is a binary search over the blocks, then one over the fixed-width
+ * entries of a single block.
+ */
+class IntervalStore {
+public:
+  static constexpr int BLOCK = 64;
+
+  // Ranges have to come sorted by start. A range overlapping or touching the
+  // previous one is merged into it.
+  void add(Interval range) {
+    if (has_last && range.first - 1 <= last.second) {
+      last.second = std::max(last.second, range.second);
+      return;
+    }
+    if (has_last)
+      push(last);
+    last = range;
+    has_last = true;
+  }
+
+  // Call once after the last add
+  void finish() {
+    if (has_last)
+      push(last);
+    has_last = false;
+    flush();
+  }
+
+  bool contains(long long id) const {
+    auto it = std::upper_bound(mins.begin(), mins.end(), id);
+    if (it == mins.begin())
+      return false;
+    size_t b = it - mins.begin() - 1;
+    const Block &block = blocks[b];
+    uint64_t rel = id - mins[b];
+    int entry = block.start_bits + block.len_bits;
+
+    // Last entry starting at or before id (the first one starts at 0)
+    size_t lo = 0;
+    for (size_t n = block.count; n > 1;) {
+      size_t half = n / 2;
+      if (read(block.offset + (lo + half) * entry, block.start_bits) <= rel)
+        lo += half;
+      n -= half;
+    }
+    size_t pos = block.offset + lo * entry;
+    return rel - read(pos, block.start_bits) <=
+           read(pos + block.start_bits, block.len_bits);
+  }
+
+  long long total() const { return covered; } // ids in all the ranges
+  size_t size() const { return ranges; }
+  size_t bytes() const {
+    return mins.size() * sizeof(long long) + blocks.size() * sizeof(Block) +
+           words.size() * sizeof(uint64_t);
+  }
+
+private:
+  struct Block {
+    uint64_t offset; // in bits, into words
+    uint8_t count;
+    uint8_t start_bits;
+    uint8_t len_bits;
+  };
+
+  void push(Interval range) {
+    pending.push_back(range);
+    covered += range.second - range.first + 1;
+    ranges++;
+    if (pending.size() == BLOCK)
+      flush();
+  }
+
+  void flush() {
+    if (pending.empty())
+      return;
+    long long min = pending[0].first;
+    uint64_t max_len = 0;
+    for (const auto &[start, end] : pending)
+      max_len |= uint64_t(end - start);
+    Block block{bits, uint8_t(pending.size()),
+                uint8_t(std::bit_width(uint64_t(pending.back().first - min))),
+                uint8_t(std::bit_width(max_len))};
+    for (const auto &[start, end] : pending) {
+      write(start - min, block.start_bits);
+      write(end - start, block.len_bits);
+    }
+    mins.push_back(min);
+    blocks.push_back(block);
+    pending.clear();
+  }
+
+  void write(uint64_t value, int width) {
+    if (width == 0)
+      return;
+    int shift = bits % 64;
+    if (shift == 0)
+      words.push_back(0);
+    words.back() |= value << shift;
+    if (shift + width > 64)
+      words.push_back(value >> (64 - shift));
+    bits += width;
+  }
+
+  uint64_t read(size_t pos, int width) const {
+    if (width == 0)
+      return 0;
+    size_t word = pos / 64;
+    int shift = pos % 64;
+    uint64_t value = words[word] >> shift;
+    if (shift + width > 64)
+      value |= words[word + 1] << (64 - shift);
+    return width == 64 ? value : value & ((uint64_t(1) << width) - 1);
+  }
+
+  std::vector<long long> mins; // first start of every block
+  std::vector<Block> blocks;
+  std::vector<uint64_t> words;
+  uint64_t bits = 0;
+
+  std::vector<Interval> pending; // ranges of the block being built
+  Interval last{};
+  bool has_last = false;
+  long long covered = 0;
+  size_t ranges = 0;
+};
+
+// Sorts the ranges in place, so move them in if they aren't needed after
+IntervalStore pack_intervals(std::vector<Interval> ranges) {
+  AOC_PERF_SCOPE("day_05 pack", ranges.size());
+  sort_by_start(ranges);
+  IntervalStore store;
+  for (const auto &range : ranges)
+    store.add(range);
+  store.finish();
+  return store;
+}
+
+// Binary search for the first merged range that starts after the id
+bool is_fresh(std::span<const Interval> merged, long long id) {
+  auto it = std::upper_bound(
+      merged.begin(), merged.end(), id,
+      [](long long val, const Interval &range) { return val < range.first; });
+  return it != merged.begin() && id <= std::prev(it)->second;
+}
+
+long long fresh_total(std::span<const Interval> merged) {
+  long long ans = 0;
+  for (auto &[start, end] : merged)
+    ans += end - start + 1;
+  return ans;
+}
+
 void part1(const Input &data) {
-  auto merged = merge_intervals(data.ranges);
+  AOC_PERF_SCOPE("day_05 part1", data.ids.size());
+  auto merged = merge_intervals({data.ranges.begin(), data.ranges.end()});
   int ans = 0;
 
-  for (const auto &[start, end] : data.ranges) {
-    // Binary search for the fist id that starts after the query
-    auto it = std::upper_bound(
-        merged.begin(), merged.end(), start,
-        [](long long val, const Interval &range) { return val < range.first; });
-    if (it != merged.begin()) {
-      auto prev = *std::prev(it);
-      if (start <= prev.second) {
-        ans++;
-      }
-    }
+  // The question is about the ids, the ranges are only the lookup table
+  for (long long id : data.ids) {
+    if (is_fresh(merged, id))
+      ans++;
   }
 
-  std::cout << ans << std::endl;
+  aoc::io::out() << ans << std::endl;
 }
 
 void part2(const Input &data) {
-  auto merged = merge_intervals(data.ranges);
-  long long ans = 0;
+  AOC_PERF_SCOPE("day_05 part2", data.ranges.size());
+  auto merged = merge_intervals({data.ranges.begin(), data.ranges.end()});
+  aoc::io::out() << fresh_total(merged) << std::endl;
+}
 
-  for (auto &[start, end] : merged) {
-    ans += end - start + 1;
+// Packed engine: same answers from an IntervalStore, for huge range sets
+void solve_packed(std::vector<Interval> ranges,
+                  std::span<const long long> ids) {
+  IntervalStore store = pack_intervals(std::move(ranges));
+  AOC_PERF_SCOPE("day_05 packed queries", ids.size());
+  int ans = 0;
+  for (long long id : ids) {
+    if (store.contains(id))
+      ans++;
   }
+  aoc::io::out() << ans << std::endl;
+  aoc::io::out() << store.total() << std::endl;
+}
 
-  std::cout << ans << std::endl;
+// Streaming engine: all the ranges come before the ids, so they are merged
+// once the first id shows up, and every id after that is answered as soon as
+// it has been read.
+void solve_stream() {
+  std::vector<Interval> ranges, merged;
+  bool ranges_done = false;
+  int fresh = 0;
+  aoc::io::for_each_line([&](std::string_view line) {
+    Interval range;
+    long long id;
+    if (parse_line(line, range, id)) {
+      ranges.push_back(range);
+      return;
+    }
+    if (!ranges_done) {
+      merged = merge_intervals(std::move(ranges));
+      ranges_done = true;
+    }
+    if (is_fresh(merged, id))
+      fresh++;
+  });
+  if (!ranges_done)
+    merged = merge_intervals(std::move(ranges));
+  aoc::io::out() << fresh << std::endl;
+  aoc::io::out() << fresh_total(merged) << std::endl;
 }
 
-int main() {
-  auto lines = aoc::io::read_lines();
-  auto data = parse_input(lines);
+// Entry point for the multi-day runner: default engine, no cache
+void solve(std::string_view input) {
+  auto parsed = parse_input(aoc::io::split_lines(input));
+  Input data{parsed.ranges, parsed.ids};
+  part1(data);
+  part2(data);
+}
+
+[[maybe_unused]] const bool registered = aoc::register_day(5, solve);
+
+} // namespace day_05
 
+#ifndef AOC_RUNNER
+int main(int argc, char **argv) {
+  using namespace day_05;
+
+  // Optional: "stream" answers the ids while stdin is still being read,
+  // "packed" answers them from the compressed IntervalStore
+  std::string_view engine = argc > 1 ? argv[1] : "";
+  if (engine == "stream") {
+    AOC_ALLOC_PHASE("stream");
+    solve_stream();
+    return 0;
+  }
+
+  auto store = aoc::cache::Store::open("day_05 ranges ids v1");
+  ParsedInput parsed;
+  if (!store.hit()) {
+    AOC_ALLOC_PHASE("read");
+    auto lines = aoc::io::read_lines();
+    AOC_ALLOC_PHASE("parse");
+    parsed = parse_input(lines);
+    store.put(parsed.ranges);
+    store.put(parsed.ids);
+    store.save();
+  }
+  Input data{store.get<Interval>(0), store.get<long long>(1)};
+
+  if (engine == "packed") {
+    AOC_ALLOC_PHASE("packed");
+    // The store sorts its ranges in place: hand it the parsed ones, or a
+    // copy of the read-only mapping on a cache hit
+    std::vector<Interval> ranges;
+    if (store.hit())
+      ranges.assign(data.ranges.begin(), data.ranges.end());
+    else
+      ranges = std::move(parsed.ranges);
+    solve_packed(std::move(ranges), data.ids);
+    return 0;
+  }
+
+  AOC_ALLOC_PHASE("part1");
   part1(data);
+  AOC_ALLOC_PHASE("part2");
   part2(data);
 
   return 0;
 }
+#endif
 
 /** Notes
  * The input has this form: a list of fresh ingredient ID ranges, a blank
@@ -135,4 +413,27 @@ int main() {
  *
  * TC: O(n log n) -> sorting the ranges takes O(n log n) time.
  * SC: O(n) -> we need to store the fresh ranges and the IDs to check.
+ *
+ * Careful: part 1 used to loop over the ranges instead of the IDs, checking
+ whether each range start is fresh. That is always true after the merge, so
+ it was just counting the ranges: 4 on the example instead of 3. It has to
+ loop over the IDs.
+ *
+ * The IDs don't need to be stored at all: every range comes before the blank
+ * line, so by the time the first ID shows up the ranges can be merged, and
+ * each ID is a binary search done as soon as its line is read.
+ *
+ * SC: O(r) -> only the ranges
+ *
+ * With hundreds of millions of ranges, 16 bytes per merged range is a lot, and
+ * most of those bits are the same: neighbouring starts share their high bits
+ * and lengths are small. So the "packed" engine keeps blocks of 64 ranges,
+ * each start as an offset from the block's first one plus the length, both
+ * with just enough bits for that block. Fixed widths inside a block mean the
+ * entries can still be binary searched, so a query touches the (small) array
+ * of block starts and one block, nothing else.
+ * The sort before the merge only needs the starts, so it's a radix sort
+ * (shared with day_08) instead of comparing pairs.
+ *
+ * SC: about 5 bytes per range for dense inputs instead of 16
  */
@@ -1,22 +1,45 @@
+#include "shared/alloc.hpp"
+#include "shared/arena.hpp"
 #include "shared/io.hpp"
+#include "shared/perf.hpp"
+#include "shared/registry.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <cstddef>
 #include <iostream>
-#include <sstream>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
-std::vector<std::vector<std::string>>
-transpose_tokens(const std::vector<std::vector<std::string>> &matrix) {
+namespace day_06 {
+
+// Every token, row and column lives in a per-part arena: building them is a
+// pointer bump and tearing them down is a single release.
+using Tokens = std::pmr::vector<std::pmr::string>;
+using TokenMatrix = std::pmr::vector<Tokens>;
+
+long long to_number(std::string_view s) {
+  long long v = 0;
+  std::from_chars(s.data(), s.data() + s.size(), v);
+  return v;
+}
+
+TokenMatrix transpose_tokens(const TokenMatrix &matrix,
+                             std::pmr::memory_resource *mem) {
   if (matrix.empty())
-    return {};
+    return TokenMatrix(mem);
 
   size_t max_width = 0;
   for (const auto &row : matrix) {
     max_width = std::max(max_width, row.size());
   }
 
-  std::vector<std::vector<std::string>> transposed(
-      max_width, std::vector<std::string>(matrix.size()));
+  // Rows are constructed with the matrix's resource (uses-allocator)
+  TokenMatrix transposed(max_width, mem);
+  for (auto &row : transposed)
+    row.resize(matrix.size());
   for (size_t i = 0; i < matrix.size(); ++i) {
     for (size_t j = 0; j < matrix[i].size(); ++j) {
       transposed[j][i] = matrix[i][j];
@@ -25,20 +48,31 @@ transpose_tokens(const std::vector<std::vector<std::string>> &matrix) {
   return transposed;
 }
 
-void part1(const std::vector<std::string> &lines) {
-  std::vector<std::vector<std::string>> input_matrix;
+void part1(const aoc::io::Lines &lines) {
+  AOC_PERF_SCOPE("day_06 part1", aoc::perf::total_size(lines));
+  aoc::Arena arena;
+  TokenMatrix input_matrix(arena);
+  input_matrix.reserve(lines.size());
 
   for (const auto &line : lines) {
-    std::vector<std::string> row;
-    std::istringstream iss(line);
-    std::string token;
-    while (iss >> token) {
-      row.push_back(token);
+    auto &row = input_matrix.emplace_back();
+    // Whitespace separated tokens, without going through a stringstream.
+    // Same separators as operator>> (a line never holds '\n'), so tabs and
+    // CRLF line endings still split.
+    constexpr std::string_view space = " \t\r\v\f";
+    std::string_view rest = line;
+    while (true) {
+      size_t begin = rest.find_first_not_of(space);
+      if (begin == std::string_view::npos)
+        break;
+      rest.remove_prefix(begin);
+      size_t len = std::min(rest.find_first_of(space), rest.size());
+      row.emplace_back(rest.substr(0, len));
+      rest.remove_prefix(len);
     }
-    input_matrix.push_back(row);
   }
 
-  auto matrix = transpose_tokens(input_matrix);
+  auto matrix = transpose_tokens(input_matrix, arena);
 
   long long ans = 0;
   for (auto &row : matrix) {
@@ -46,35 +80,35 @@ void part1(const std::vector<std::string> &lines) {
       continue;
 
     long long row_res = 0;
-    std::string op = row.back();
+    const auto &op = row.back();
 
     if (op == "+") {
       for (size_t i = 0; i < row.size() - 1; ++i) {
         if (row[i].empty())
           continue; // Skip padding from transpose
-        row_res += std::stoll(row[i]);
+        row_res += to_number(row[i]);
       }
     } else if (op == "*") {
       row_res = 1; // Initialize multiplication identity
       for (size_t i = 0; i < row.size() - 1; ++i) {
         if (row[i].empty())
           continue; // Skip padding
-        row_res *= std::stoll(row[i]);
+        row_res *= to_number(row[i]);
       }
     }
 
     ans += row_res;
   }
 
-  std::cout << ans << std::endl;
+  aoc::io::out() << ans << std::endl;
 }
 
-long long solve_block(const std::vector<std::string> &cols) {
+long long solve_block(const Tokens &cols, std::pmr::memory_resource *mem) {
   if (cols.empty())
     return 0;
 
   char op = 0;
-  std::vector<long long> numbers;
+  std::pmr::vector<long long> numbers(mem);
 
   for (const auto &col : cols) {
     char bottom_char = col.back();
@@ -82,15 +116,18 @@ long long solve_block(const std::vector<std::string> &cols) {
       op = bottom_char;
     }
 
-    std::string num_str;
+    // Digits top to bottom, most significant first
+    long long num = 0;
+    bool has_digits = false;
     for (char c : col) {
       if (std::isdigit(c)) {
-        num_str += c;
+        num = num * 10 + (c - '0');
+        has_digits = true;
       }
     }
 
-    if (!num_str.empty()) {
-      numbers.push_back(std::stoll(num_str));
+    if (has_digits) {
+      numbers.push_back(num);
     }
   }
 
@@ -108,14 +145,16 @@ long long solve_block(const std::vector<std::string> &cols) {
   return res;
 }
 
-void part2(const std::vector<std::string> &lines) {
+void part2(const aoc::io::Lines &lines) {
+  AOC_PERF_SCOPE("day_06 part2", aoc::perf::total_size(lines));
   if (lines.empty())
     return;
   size_t max_width = 0;
   for (const auto &line : lines)
     max_width = std::max(max_width, line.size());
 
-  std::vector<std::string> grid = lines;
+  aoc::Arena arena;
+  aoc::io::Lines grid(lines.begin(), lines.end(), arena);
   for (auto &row : grid) {
     row.resize(max_width, ' ');
   }
@@ -124,10 +163,12 @@ void part2(const std::vector<std::string> &lines) {
   size_t height = grid.size();
 
   // Buffer to hold columns for the current problem
-  std::vector<std::string> cols;
+  Tokens cols(arena);
+  std::pmr::string col_chars(arena);
+  col_chars.reserve(height);
   for (int x = (int)max_width - 1; x >= -1; --x) {
     bool is_separator = false;
-    std::string col_chars;
+    col_chars.clear();
 
     if (x == -1) {
       is_separator = true;
@@ -144,7 +185,7 @@ void part2(const std::vector<std::string> &lines) {
 
     if (is_separator) {
       if (!cols.empty()) {
-        ans += solve_block(cols);
+        ans += solve_block(cols, arena);
         cols.clear();
       }
     } else {
@@ -152,17 +193,37 @@ void part2(const std::vector<std::string> &lines) {
       cols.push_back(col_chars);
     }
   }
-  std::cout << ans << std::endl;
+  aoc::io::out() << ans << std::endl;
 }
 
+// Entry point for the multi-day runner: default engine, no cache
+void solve(std::string_view input) {
+  aoc::Arena arena;
+  auto lines = aoc::io::split_lines(input, arena);
+  part1(lines);
+  part2(lines);
+}
+
+[[maybe_unused]] const bool registered = aoc::register_day(6, solve);
+
+} // namespace day_06
+
+#ifndef AOC_RUNNER
 int main() {
-  auto lines = aoc::io::read_lines();
+  using namespace day_06;
+
+  aoc::Arena arena;
+  AOC_ALLOC_PHASE("read");
+  auto lines = aoc::io::read_lines(arena);
 
+  AOC_ALLOC_PHASE("part1");
   part1(lines);
+  AOC_ALLOC_PHASE("part2");
   part2(lines);
 
   return 0;
 }
+#endif
 
 /** Notes
  *
@@ -1,29 +1,38 @@
+#include "shared/alloc.hpp"
 #include "shared/io.hpp"
+#include "shared/perf.hpp"
+#include "shared/pipeline.hpp"
+#include "shared/registry.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
-#include <numeric>
+#include <map>
+#include <optional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
-void part1(const std::vector<std::string> &lines) {
-
-  int rows = lines.size();
-  int cols = lines[0].length();
+namespace day_07 {
 
-  std::vector<bool> current_beam(cols, false);
-
-  // find S
-  for (int c = 0; c < cols; c++)
-    if (lines[0][c] == 'S') {
-      current_beam[c] = true;
-      break; // there's only one starting point
-    }
+// Part 1 one row at a time, so it can also run on a stream
+class BeamHits {
+public:
+  BeamHits(int cols, int start) : current_beam(cols, false) {
+    current_beam[start] = true; // there's only one starting point
+  }
 
-  long long ans = 0;
-  for (int i = 0; i < rows; i++) {
+  void feed(std::string_view row) {
+    int cols = current_beam.size();
     std::vector<bool> next_beam(cols, false);
 
     for (int c = 0; c < cols; c++) {
       if (current_beam[c]) {
-        char cell = lines[i][c];
+        char cell = row[c];
 
         if (cell == '.' || cell == 'S') {
           next_beam[c] = true;
@@ -41,51 +50,467 @@ void part1(const std::vector<std::string> &lines) {
     }
     current_beam = next_beam;
   }
-  std::cout << ans << std::endl;
+
+  long long hits() const { return ans; }
+
+private:
+  std::vector<bool> current_beam;
+  long long ans = 0;
+};
+
+// Column of S on the first row, -1 if there's none (no beam at all)
+int find_start(std::string_view first_row) {
+  size_t start = first_row.find('S');
+  return start == first_row.npos ? -1 : int(start);
 }
 
-void part2(const std::vector<std::string> &lines) {
-  int rows = lines.size();
+int find_start(const std::vector<std::string> &lines) {
+  return find_start(lines[0]);
+}
+
+void part1(const std::vector<std::string> &lines) {
+
+  int cols = lines[0].length();
+  AOC_PERF_SCOPE("day_07 part1", uint64_t(lines.size()) * cols);
+
+  BeamHits beams(cols, find_start(lines));
+  for (const auto &line : lines)
+    beams.feed(line);
+  aoc::io::out() << beams.hits() << std::endl;
+}
+
+// Timeline counts grow exponentially with the number of splitter rows, so the
+// counter type is a template parameter: 64-bit for speed, 128-bit for deep
+// manifolds, or modular arithmetic when we only need a fingerprint of the
+// count.
+using aoc::u128;
+
+struct ModCount {
+  static constexpr uint64_t MOD = (1ULL << 61) - 1; // Mersenne prime
+
+  uint64_t v = 0;
+
+  ModCount() = default;
+  ModCount(uint64_t x) : v(x % MOD) {}
+
+  ModCount &operator+=(ModCount o) {
+    v += o.v; // both < 2^61, no overflow
+    v = v >= MOD ? v - MOD : v;
+    return *this;
+  }
+  friend ModCount operator+(ModCount a, ModCount b) { return a += b; }
+};
+
+using aoc::io::to_string; // u128
+std::string to_string(uint64_t v) { return std::to_string(v); }
+
+std::string to_string(ModCount v) { return std::to_string(v.v); }
+
+// Part 2 one row at a time. Column c of the grid lives at index c + 1: the two
+// padding cells catch the beams that fall off the edges and are never read
+// back.
+template <typename Count> class TimelineCounter {
+public:
+  TimelineCounter(int cols, int start)
+      : cols(cols), current_beam(cols + 2), next_beam(cols + 2),
+        split(cols + 2, 0), lo(start), hi(start) {
+    current_beam[start + 1] = 1;
+  }
+
+  void feed(std::string_view line) {
+    const char *row = line.data();
+    // No splitter in reach: every beam goes straight down, nothing to do.
+    if (!std::memchr(row + lo, '^', hi - lo + 1))
+      return;
+
+    lo = std::max(lo - 1, 0);
+    hi = std::min(hi + 1, cols - 1);
+    for (int c = lo; c <= hi; c++)
+      split[c + 1] = row[c] == '^';
+
+    // Gather instead of scatter: each cell keeps its own beam unless it's a
+    // splitter, and receives the beams of the splitters next to it.
+    // Cells outside the previous window hold zero, so stale mask values there
+    // don't matter.
+    const Count zero{};
+    for (int b = lo + 1; b <= hi + 1; b++) {
+      next_beam[b] = (split[b] ? zero : current_beam[b]) +
+                     (split[b - 1] ? current_beam[b - 1] : zero) +
+                     (split[b + 1] ? current_beam[b + 1] : zero);
+    }
+    std::swap(current_beam, next_beam);
+  }
+
+  Count total() const {
+    Count ans{};
+    for (int b = lo + 1; b <= hi + 1; b++)
+      ans += current_beam[b];
+    return ans;
+  }
+
+private:
+  int cols;
+  std::vector<Count> current_beam, next_beam;
+  std::vector<uint8_t> split;
+  // Active window: beams can only spread by one column per splitter row, so
+  // everything outside [lo, hi] is known to be zero.
+  int lo, hi;
+};
+
+template <typename Count>
+Count count_timelines(const std::vector<std::string> &lines, int start) {
   int cols = lines[0].length();
+  AOC_PERF_SCOPE("day_07 row updates", uint64_t(lines.size()) * cols);
 
-  std::vector<long long> current_beam(cols);
+  TimelineCounter<Count> timelines(cols, start);
+  for (const auto &line : lines)
+    timelines.feed(line);
+  return timelines.total();
+}
 
-  // find S
-  for (int c = 0; c < cols; c++)
-    if (lines[0][c] == 'S') {
-      current_beam[c] = 1;
-      break; // there's only one starting point
+template <typename Count> void part2(const std::vector<std::string> &lines) {
+  aoc::io::out() << to_string(
+                        count_timelines<Count>(lines, find_start(lines)))
+                 << std::endl;
+}
+
+// Sparse engine: on mostly-empty manifolds, walking the grid row by row wastes
+// time on cells no beam ever reaches. Instead each beam falls straight to the
+// next splitter in its column.
+struct SplitterIndex {
+  int rows = 0;
+  int cols = 0;
+  int start = 0;
+  std::vector<std::vector<int>> by_col; // splitter rows per column, sorted
+
+  // First splitter at or below row r in column c, or -1 if the beam exits.
+  int next_splitter(int c, int r) const {
+    const auto &col = by_col[c];
+    auto it = std::lower_bound(col.begin(), col.end(), r);
+    return it == col.end() ? -1 : *it;
+  }
+};
+
+SplitterIndex build_index(const std::vector<std::string> &lines) {
+  SplitterIndex idx;
+  idx.rows = lines.size();
+  idx.cols = lines[0].length();
+  idx.start = find_start(lines);
+  idx.by_col.resize(idx.cols);
+
+  // Rows are scanned top to bottom, so each column comes out sorted
+  for (int i = 0; i < idx.rows; i++) {
+    const char *row = lines[i].data();
+    const char *end = row + idx.cols;
+    for (const char *p = row; (p = static_cast<const char *>(
+                                   std::memchr(p, '^', end - p))) != nullptr;
+         p++)
+      idx.by_col[p - row].push_back(i);
+  }
+  return idx;
+}
+
+template <typename Count> struct SparseResult {
+  long long hits = 0; // part 1
+  Count timelines{};  // part 2
+};
+
+template <typename Count>
+SparseResult<Count> simulate_sparse(const SplitterIndex &idx) {
+  AOC_PERF_SCOPE("day_07 sparse", uint64_t(idx.rows) * idx.cols);
+  using Event = std::pair<int, int>; // (row, col) of a splitter about to be hit
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  std::map<int, Count> beams; // col -> timelines currently falling in it
+
+  SparseResult<Count> res;
+
+  // Drop a beam into column c at row r. If the column already carries a beam,
+  // it hasn't reached its splitter yet (events are processed in row order),
+  // so both hit the same one: merge them.
+  auto drop = [&](int c, int r, Count count) {
+    if (c < 0 || c >= idx.cols)
+      return;
+    auto [it, inserted] = beams.try_emplace(c, count);
+    if (!inserted) {
+      it->second += count;
+      return;
     }
+    int hit = idx.next_splitter(c, r);
+    if (hit >= 0)
+      events.push({hit, c});
+  };
 
-  for (int i = 0; i < rows; i++) {
-    std::vector<long long> next_beam(cols, 0);
-    for (int c = 0; c < cols; c++) {
-      if (current_beam[c] > 0) {
-        if (lines[i][c] == '.' || lines[i][c] == 'S') {
-          next_beam[c] += current_beam[c];
-        } else if (lines[i][c] == '^') {
-          if (c < cols - 1)
-            next_beam[c + 1] += current_beam[c];
-          if (c > 0)
-            next_beam[c - 1] += current_beam[c];
+  drop(idx.start, 0, Count(1));
+
+  std::vector<std::pair<int, Count>> split;
+  while (!events.empty()) {
+    int row = events.top().first;
+
+    // Take every beam hitting a splitter on this row before dropping the new
+    // ones, otherwise a new beam could merge into one that is being split.
+    split.clear();
+    while (!events.empty() && events.top().first == row) {
+      int c = events.top().second;
+      events.pop();
+      auto it = beams.find(c);
+      split.push_back({c, it->second});
+      beams.erase(it);
+      res.hits++;
+    }
+
+    for (const auto &[c, count] : split) {
+      drop(c - 1, row + 1, count);
+      drop(c + 1, row + 1, count);
+    }
+  }
+
+  // Whatever is left falls out of the bottom of the manifold
+  for (const auto &[c, count] : beams)
+    res.timelines += count;
+  return res;
+}
+
+template <typename Count>
+void solve_sparse(const std::vector<std::string> &lines) {
+  auto res = simulate_sparse<Count>(build_index(lines));
+  aoc::io::out() << res.hits << std::endl;
+  aoc::io::out() << to_string(res.timelines) << std::endl;
+}
+
+// Batch mode: the answers for every start column of the same manifold.
+template <typename Count> struct AllStarts {
+  std::vector<long long> hits;  // part 1, indexed by start column
+  std::vector<Count> timelines; // part 2, indexed by start column
+};
+
+// Reverse DP: below[c + 1] is the number of timelines of a beam entering
+// column c under the current row, 1 everywhere past the last row. Going up,
+// a splitter's value is the sum of its two neighbours below, anything else
+// passes its own down. Beams off the edges are lost, like in
+// count_timelines: the padding cells stay 0.
+template <typename Count>
+std::vector<Count> timelines_all_starts(const std::vector<std::string> &lines) {
+  int rows = lines.size();
+  int cols = lines[0].length();
+  AOC_PERF_SCOPE("day_07 reverse dp", uint64_t(rows) * cols);
+
+  std::vector<Count> below(cols + 2, Count(1)), above(cols + 2);
+  below[0] = below[cols + 1] = Count{};
+  for (int i = rows - 1; i >= 0; i--) {
+    const char *row = lines[i].data();
+    if (!std::memchr(row, '^', cols))
+      continue;
+    for (int c = 0; c < cols; c++)
+      above[c + 1] = row[c] == '^' ? below[c] + below[c + 2] : below[c + 1];
+    std::swap(above, below);
+  }
+  return {below.begin() + 1, below.end() - 1};
+}
+
+// Splitter hits can't be summed bottom-up like timelines: two paths reaching
+// the same splitter must count it once. So this goes top-down with, for
+// every column, the set of start columns whose beam is in it (a bitset, W
+// words), and every splitter adds its set to per-start counters. The
+// counters are bit-sliced: slice l holds bit l of every counter, so adding a
+// set is a word-wide ripple carry. O(rows * cols * cols / 64).
+// The sets take (cols + 2) * W words twice over, which grows as cols^2, so
+// the starts are done in batches of at most 64 * W columns, W picked to keep
+// both buffers within MAX_SET_BYTES.
+constexpr size_t MAX_SET_BYTES = size_t(1) << 28;
+
+// Hits of the starts in [first, first + 64 * W), written to hits
+void hits_for_starts(const std::vector<std::string> &lines, size_t first,
+                     size_t W, int slices, std::vector<long long> &hits) {
+  size_t cols = lines[0].length();
+  size_t last = std::min(cols, first + 64 * W);
+
+  // Column c at index c + 1, padding catches the beams falling off the edges
+  std::vector<uint64_t> cur((cols + 2) * W, 0), next((cols + 2) * W);
+  std::vector<uint64_t> counter(slices * W, 0);
+  for (size_t c = first; c < last; c++)
+    cur[(c + 1) * W + (c - first) / 64] |= uint64_t(1) << ((c - first) % 64);
+
+  for (const auto &line : lines) {
+    const char *row = line.data();
+    if (!std::memchr(row, '^', cols))
+      continue;
+    std::fill(next.begin(), next.end(), 0);
+    for (size_t c = 0; c < cols; c++) {
+      const uint64_t *starts = &cur[(c + 1) * W];
+      if (row[c] != '^') {
+        for (size_t w = 0; w < W; w++)
+          next[(c + 1) * W + w] |= starts[w];
+        continue;
+      }
+      for (size_t w = 0; w < W; w++) {
+        next[c * W + w] |= starts[w];
+        next[(c + 2) * W + w] |= starts[w];
+        for (uint64_t carry = starts[w], l = 0; carry; l++) {
+          uint64_t &slice = counter[l * W + w];
+          uint64_t overflow = slice & carry;
+          slice ^= carry;
+          carry = overflow;
         }
       }
     }
-    current_beam = next_beam;
+    std::swap(cur, next);
+  }
+
+  for (size_t c = first; c < last; c++) {
+    size_t bit = c - first;
+    for (int l = 0; l < slices; l++)
+      hits[c] |= (long long)((counter[l * W + bit / 64] >> (bit % 64)) & 1)
+                 << l;
   }
-  unsigned long long ans =
-      std::accumulate(current_beam.begin(), current_beam.end(), 0LL);
-  std::cout << ans;
 }
 
-int main() {
-  auto lines = aoc::io::read_lines();
+std::vector<long long> hits_all_starts(const std::vector<std::string> &lines) {
+  size_t cols = lines[0].length();
+  AOC_PERF_SCOPE("day_07 hit sets", uint64_t(lines.size()) * cols);
+
+  long long splitters = 0;
+  for (const auto &line : lines)
+    splitters += std::count(line.begin(), line.end(), '^');
+  int slices = std::bit_width(uint64_t(splitters)) + 1;
+
+  size_t W = (cols + 63) / 64;
+  size_t budget = MAX_SET_BYTES / (2 * (cols + 2) * sizeof(uint64_t));
+  W = std::max<size_t>(1, std::min(budget, W));
+
+  std::vector<long long> hits(cols, 0);
+  for (size_t first = 0; first < cols; first += 64 * W)
+    hits_for_starts(lines, first, W, slices, hits);
+  return hits;
+}
+
+template <typename Count>
+AllStarts<Count> solve_all_starts(const std::vector<std::string> &lines) {
+  return {hits_all_starts(lines), timelines_all_starts<Count>(lines)};
+}
 
+// One line per start column: "column hits timelines"
+template <typename Count>
+void print_all_starts(const std::vector<std::string> &lines) {
+  auto all = solve_all_starts<Count>(lines);
+  for (size_t c = 0; c < all.hits.size(); c++)
+    aoc::io::out() << c << ' ' << all.hits[c] << ' '
+                   << to_string(all.timelines[c]) << '\n';
+}
+
+template <typename Count>
+void solve(const std::vector<std::string> &lines, bool sparse) {
+  if (find_start(lines) < 0) { // nothing enters the manifold
+    aoc::io::out() << 0 << std::endl << 0 << std::endl;
+    return;
+  }
+  if (sparse) {
+    AOC_ALLOC_PHASE("sparse");
+    solve_sparse<Count>(lines);
+    return;
+  }
+  AOC_ALLOC_PHASE("part1");
   part1(lines);
-  part2(lines);
+  AOC_ALLOC_PHASE("part2");
+  part2<Count>(lines);
+}
+
+// Streaming engine: both parts advance as soon as a row has been read. The
+// first row sets the width and holds S; without an S the rest is skipped.
+template <typename Count> void solve_stream() {
+  bool first = true;
+  std::optional<BeamHits> beams;
+  std::optional<TimelineCounter<Count>> timelines;
+  aoc::io::for_each_line([&](std::string_view row) {
+    if (std::exchange(first, false)) {
+      int start = find_start(row);
+      if (start < 0)
+        return;
+      beams.emplace(row.size(), start);
+      timelines.emplace(row.size(), start);
+    }
+    if (!beams)
+      return;
+    beams->feed(row);
+    timelines->feed(row);
+  });
+  if (first)
+    return;
+  if (!beams) {
+    aoc::io::out() << 0 << std::endl << 0 << std::endl;
+    return;
+  }
+  aoc::io::out() << beams->hits() << std::endl;
+  aoc::io::out() << to_string(timelines->total()) << std::endl;
+}
+
+// Entry point for the multi-day runner: default engine, no cache
+void solve(std::string_view input) {
+  solve<uint64_t>(aoc::io::split_lines(input), false);
+}
+
+[[maybe_unused]] const bool registered = aoc::register_day(7, solve);
+
+} // namespace day_07
+
+#ifndef AOC_RUNNER
+int main(int argc, char **argv) {
+  using namespace day_07;
+
+  // Optional flags: "sparse" switches to the event-driven engine, "all"
+  // answers for every start column instead of S, "stream" solves the rows
+  // while stdin is still being read (not with sparse or all), "u128" or
+  // "mod" pick the part 2 counter type (u64 by default)
+  bool sparse = false, all = false, stream = false;
+  std::string_view count_type = "u64";
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    if (arg == "sparse")
+      sparse = true;
+    else if (arg == "all")
+      all = true;
+    else if (arg == "stream")
+      stream = true;
+    else
+      count_type = arg;
+  }
+
+  if (stream && (sparse || all)) {
+    // Both need the whole grid before they can start
+    std::cerr << "stream can't be combined with sparse or all" << std::endl;
+    return 1;
+  }
+  if (stream) {
+    AOC_ALLOC_PHASE("stream");
+    if (count_type == "u128")
+      solve_stream<u128>();
+    else if (count_type == "mod")
+      solve_stream<ModCount>();
+    else
+      solve_stream<uint64_t>();
+    return 0;
+  }
+
+  AOC_ALLOC_PHASE("read");
+  auto lines = aoc::io::read_lines();
+
+  if (all) {
+    AOC_ALLOC_PHASE("all starts");
+    if (count_type == "u128")
+      print_all_starts<u128>(lines);
+    else if (count_type == "mod")
+      print_all_starts<ModCount>(lines);
+    else
+      print_all_starts<uint64_t>(lines);
+  } else if (count_type == "u128")
+    solve<u128>(lines, sparse);
+  else if (count_type == "mod")
+    solve<ModCount>(lines, sparse);
+  else
+    solve<uint64_t>(lines, sparse);
 
   return 0;
 }
+#endif
 
 /** Notes
  * The input is a 2d grid with starting point S.
@@ -133,4 +558,39 @@ int main() {
  *
  * For part 2 we're actually interested in how many beams we reach. To do this
  * we prepare each time the next row in the grid before parsing.
+ *
+ * Allocating the next row every time is wasteful: two buffers are enough, we
+ * just swap them after each row. Instead of pushing each beam to its
+ * neighbours (scatter), each cell can pull from its neighbours (gather):
+ * next[c] = (^ at c ? 0 : cur[c]) + (^ at c-1 ? cur[c-1] : 0) + (^ at c+1 ?
+ * cur[c+1] : 0), which has no branches and vectorises.
+ * Beams only spread one column per splitter row, so we only need to touch the
+ * [lo, hi] window around S, and rows without splitters can be skipped.
+ *
+ * The counts grow like 2^(splitter rows), so they overflow 64 bits on deep
+ * manifolds: the counter is a template (u64, u128 or mod 2^61-1).
+ *
+ * On huge manifolds with few splitters, even the windowed pass is mostly
+ * wasted work. Sparse mode indexes the splitters of each column (sorted by
+ * row) and lets each beam fall straight to the next one in its column with a
+ * binary search. Beams live in a col -> count map and the splitter hits are
+ * events in a min-heap ordered by row, so beams landing in the same column
+ * merge before they hit anything.
+ *
+ * TC: O(h log h) after indexing, h = splitters hit
+ * SC: O(s + b) -> s splitters, b active beams
+ *
+ * All start columns at once: running part 2 once per column is
+ * O(cols * rows * cols). Going bottom-up instead, the number of timelines
+ * from a cell only depends on the row below: a splitter gets the sum of its
+ * two diagonal neighbours, everything else gets the cell below, and the last
+ * row is all 1s. Row 0 then holds the answer for every start.
+ * TC: O(n * m), SC: O(m)
+ *
+ * Part 1 doesn't work like that: beams merge, and a splitter reached through
+ * two paths counts once, so counts from below can't just be added. Instead,
+ * top-down, each column carries the set of starts whose beam is in it (a
+ * bitset), and each splitter adds its set to the per-start counters
+ * (bit-sliced, so that's a ripple carry on whole words).
+ * TC: O(n * m * m / 64), SC: O(m * m / 64)
 */
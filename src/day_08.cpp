@@ -1,8 +1,34 @@
+#include "shared/alloc.hpp"
+#include "shared/arena.hpp"
+#include "shared/cache.hpp"
+#include "shared/disjoint_set.hpp"
 #include "shared/io.hpp"
+#include "shared/parallel.hpp"
+#include "shared/perf.hpp"
+#include "shared/radix_sort.hpp"
+#include "shared/registry.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <queue>
+#include <span>
 #include <sstream>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace day_08 {
+
+using aoc::u128;
+
 struct Box {
   int x, y, z;
 };
@@ -13,25 +39,7 @@ struct Edge {
   bool operator<(const Edge &other) const { return weight < other.weight; }
 };
 
-int find(int i, std::vector<int> &parent) {
-  if (parent[i] == i)
-    return i;
-  return parent[i] = find(parent[i], parent);
-}
-
-bool unite(int i, int j, std::vector<int> &parent, std::vector<int> &sz) {
-  i = find(i, parent);
-  j = find(j, parent);
-  if (i == j)
-    return false; // already connected
-  if (sz[i] < sz[j])
-    std::swap(i, j);
-  parent[j] = i;
-  sz[i] += sz[j];
-  return true; // a new connection is formed
-}
-
-void solve(const std::vector<std::string> &lines) {
+std::vector<Box> parse_boxes(const std::vector<std::string> &lines) {
   std::vector<Box> boxes;
   // line: "x, y, z"
   for (const auto &line : lines) {
@@ -41,58 +49,627 @@ void solve(const std::vector<std::string> &lines) {
     iss >> x >> c >> y >> c >> z;
     boxes.push_back({x, y, z});
   }
+  return boxes;
+}
 
-  // DSU prep
-  std::vector<int> parent(boxes.size());
-  std::vector<int> sz(boxes.size(), 1);
-  std::vector<Edge> edges;
+long long squared_dist(const Box &a, const Box &b) {
+  long long dx = a.x - b.x;
+  long long dy = a.y - b.y;
+  long long dz = a.z - b.z;
+  return dx * dx + dy * dy + dz * dz;
+}
 
-  int components = boxes.size();
+int coord(const Box &b, int axis) {
+  return axis == 0 ? b.x : (axis == 1 ? b.y : b.z);
+}
 
-  // Each node is initially its parent
-  for (size_t i = 0; i < boxes.size(); ++i) {
-    parent[i] = i;
+// Upper bound for any squared distance: the diagonal of the bounding box.
+// Spans of full-range ints need 32 bits, so the sum of their squares needs 128.
+u128 max_squared_dist(std::span<const Box> boxes) {
+  u128 max_dist = 0;
+  for (int axis = 0; axis < 3; ++axis) {
+    auto [lo, hi] = std::minmax_element(
+        boxes.begin(), boxes.end(), [&](const Box &a, const Box &b) {
+          return coord(a, axis) < coord(b, axis);
+        });
+    uint64_t span = (long long)coord(*hi, axis) - coord(*lo, axis);
+    max_dist += u128(span) * span;
   }
+  return max_dist;
+}
+
+// Start of row i in the flattened pair triangle (pairs (i, j) with j > i)
+size_t row_offset(size_t i, size_t n) { return i * (n - 1) - i * (i - 1) / 2; }
+
+// Runs Kruskal over edges pulled (in increasing weight) from next_edge until a
+// single component is left, and returns the product of the x coordinates of
+// the last two boxes joined.
+template <typename NextEdge>
+long long kruskal_last_edge(std::span<const Box> boxes, NextEdge next_edge) {
+  aoc::DisjointSet dsu(boxes.size());
 
-  for (int i = 0; i < boxes.size(); ++i) {
-    for (int j = i + 1; j < boxes.size(); ++j) {
-      // calculate squared distance between boxes
-      long long dx = boxes[i].x - boxes[j].x;
-      long long dy = boxes[i].y - boxes[j].y;
-      long long dz = boxes[i].z - boxes[j].z;
-      long long dist = dx * dx + dy * dy + dz * dz;
-      // add the edge to the list of edges
-      edges.push_back({i, j, dist});
+  long long ans = 1;
+  // process the loop and unite
+  Edge e;
+  while (dsu.count() > 1 && next_edge(e)) {
+    if (dsu.unite(e.u, e.v) && dsu.count() == 1)
+      ans = (long long)boxes[e.u].x * boxes[e.v].x;
+  }
+  return ans;
+}
+
+void solve(std::span<const Box> boxes) {
+  // All n(n-1)/2 edges in one block from the arena: reserved up front (a
+  // monotonic arena never reuses what a growing vector leaves behind) and
+  // backed by huge pages, which the sort's random accesses benefit from.
+  aoc::Arena arena;
+  std::pmr::vector<Edge> edges(arena);
+  edges.reserve(row_offset(boxes.size(), boxes.size()));
+
+  {
+    AOC_PERF_SCOPE("day_08 edge loop", row_offset(boxes.size(), boxes.size()));
+    for (int i = 0; i < (int)boxes.size(); ++i) {
+      for (int j = i + 1; j < (int)boxes.size(); ++j) {
+        // add the edge to the list of edges
+        edges.push_back({i, j, squared_dist(boxes[i], boxes[j])});
+      }
     }
   }
 
-  // sort by distance
-  std::sort(edges.begin(), edges.end());
+  {
+    // sort by distance
+    AOC_PERF_SCOPE("day_08 sort", edges.size());
+    std::sort(edges.begin(), edges.end());
+  }
+
+  AOC_PERF_SCOPE("day_08 kruskal", edges.size());
+  size_t k = 0;
+  long long ans = kruskal_last_edge(boxes, [&](Edge &e) {
+    if (k == edges.size())
+      return false;
+    e = edges[k++];
+    return true;
+  });
+
+  aoc::io::out() << ans << std::endl;
+}
+
+// Strict weak order on edges with ties broken by endpoints, so the K shortest
+// edges are the same whatever the thread count.
+bool shorter(const Edge &a, const Edge &b) {
+  return std::tie(a.weight, a.u, a.v) < std::tie(b.weight, b.u, b.v);
+}
+
+// The k shortest edges, sorted. Rows of the pair triangle are dealt to the
+// threads in blocks; each thread keeps its own k best in a bounded max-heap,
+// so memory is O(k) per thread instead of O(n^2).
+std::vector<Edge> shortest_edges(std::span<const Box> boxes, size_t k) {
+  if (k == 0)
+    return {}; // the heaps below assume room for at least one edge
+  constexpr int BLOCK = 64; // rows per tile
+  int n = boxes.size();
+  AOC_PERF_SCOPE("day_08 shortest_edges", row_offset(n, n));
+  int threads = aoc::thread_count();
+  std::vector<std::vector<Edge>> heaps(threads);
+
+  auto worker = [&](int t) {
+    auto &heap = heaps[t];
+    heap.reserve(k + 1);
+    for (int block = t * BLOCK; block < n; block += threads * BLOCK) {
+      for (int i = block; i < std::min(block + BLOCK, n); ++i) {
+        for (int j = i + 1; j < n; ++j) {
+          long long dist = squared_dist(boxes[i], boxes[j]);
+          if (heap.size() == k && dist > heap.front().weight)
+            continue; // can't make it into the k best
+          Edge e{i, j, dist};
+          if (heap.size() < k) {
+            heap.push_back(e);
+            std::push_heap(heap.begin(), heap.end(), shorter);
+          } else if (shorter(e, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), shorter);
+            heap.back() = e;
+            std::push_heap(heap.begin(), heap.end(), shorter);
+          }
+        }
+      }
+    }
+  };
+
+  aoc::run_threads(threads, worker);
+
+  // Merge: at most threads * k candidates left
+  std::vector<Edge> edges;
+  for (const auto &heap : heaps)
+    edges.insert(edges.end(), heap.begin(), heap.end());
+  if (edges.size() > k) {
+    std::nth_element(edges.begin(), edges.begin() + k, edges.end(), shorter);
+    edges.resize(k);
+  }
+  std::sort(edges.begin(), edges.end(), shorter);
+  return edges;
+}
+
+// Part 1: connect the k closest pairs and multiply the sizes of the three
+// largest circuits. The circuits don't depend on the order the pairs are
+// connected in, so large k are split between threads on a lock-free set.
+void solve_part1(std::span<const Box> boxes, size_t k) {
+  auto edges = shortest_edges(boxes, k);
+  aoc::ConcurrentDisjointSet dsu(boxes.size());
+  int threads = edges.size() < (1 << 16) ? 1 : aoc::thread_count();
+  aoc::run_threads(threads, [&](int t) {
+    size_t lo = edges.size() * t / threads;
+    size_t hi = edges.size() * (t + 1) / threads;
+    for (size_t i = lo; i < hi; ++i)
+      dsu.unite(edges[i].u, edges[i].v);
+  });
+
+  // The set doesn't track sizes: count the boxes under every root
+  std::vector<int> size(boxes.size());
+  for (size_t i = 0; i < boxes.size(); ++i)
+    size[dsu.find(i)]++;
+  std::vector<int> circuits;
+  for (int s : size)
+    if (s > 0)
+      circuits.push_back(s);
+  std::sort(circuits.begin(), circuits.end(), std::greater<int>());
 
   long long ans = 1;
-  // process the loop and unite
-  for (size_t k = 0; k < edges.size(); ++k) {
-    int i = edges[k].u;
-    int j = edges[k].v;
-    if (unite(i, j, parent, sz)) {
-      components--;
-      if (components == 1) {
-        ans = (long long)boxes[i].x * boxes[j].x;
-        break;
+  for (size_t i = 0; i < std::min<size_t>(3, circuits.size()); ++i)
+    ans *= circuits[i];
+
+  aoc::io::out() << ans << std::endl;
+}
+
+// Parallel all-pairs engine. Same algorithm as solve, but each edge is packed
+// into a single 64-bit key (dist | u | v, in that order from the top bit), so
+// sorting the keys sorts by distance and the sort can be a radix sort.
+struct EdgeKeys {
+  int bits;      // bits per endpoint
+  uint64_t mask; // (1 << bits) - 1
+  std::vector<uint64_t> keys;
+
+  Edge decode(uint64_t key) const {
+    return {int((key >> bits) & mask), int(key & mask),
+            (long long)(key >> (2 * bits))};
+  }
+};
+
+// Generates every edge into a preallocated buffer. Rows are split into
+// contiguous ranges holding the same number of pairs, one per thread, and each
+// thread writes its own slice. Returns false if the keys don't fit in 64 bits.
+bool generate_keys(std::span<const Box> boxes, int threads, EdgeKeys &out) {
+  size_t n = boxes.size();
+  if (n < 2)
+    return false; // no edges, solve handles it
+  int bits = 1;
+  while ((size_t(1) << bits) < n)
+    bits++;
+
+  u128 max_dist = max_squared_dist(boxes);
+  if (2 * bits >= 64 || (max_dist >> (64 - 2 * bits)) != 0)
+    return false;
+
+  out.bits = bits;
+  out.mask = (uint64_t(1) << bits) - 1;
+  size_t total = row_offset(n, n);
+  out.keys.resize(total);
+  AOC_PERF_SCOPE("day_08 generate_keys", total);
+
+  // Row boundaries of each thread's range
+  std::vector<size_t> first_row(threads + 1, n);
+  first_row[0] = 0;
+  for (size_t i = 0, t = 1; i < n && t < (size_t)threads; ++i)
+    if (row_offset(i, n) >= total * t / threads)
+      first_row[t++] = i;
+
+  aoc::run_threads(threads, [&](int t) {
+    uint64_t *dst = out.keys.data() + row_offset(first_row[t], n);
+    for (size_t i = first_row[t]; i < first_row[t + 1]; ++i) {
+      uint64_t hi = uint64_t(i) << bits;
+      for (size_t j = i + 1; j < n; ++j) {
+        uint64_t dist = squared_dist(boxes[i], boxes[j]);
+        *dst++ = (dist << (2 * bits)) | hi | j;
+      }
+    }
+  });
+  return true;
+}
+
+void solve_parallel(std::span<const Box> boxes) {
+  int threads = aoc::thread_count();
+  EdgeKeys edges;
+  if (!generate_keys(boxes, threads, edges)) {
+    solve(boxes); // too many boxes or too far apart for 64-bit keys
+    return;
+  }
+  {
+    AOC_PERF_SCOPE("day_08 radix_sort", edges.keys.size());
+    aoc::radix_sort(edges.keys, [](uint64_t key) { return key; }, threads);
+  }
+
+  size_t k = 0;
+  long long ans = kruskal_last_edge(boxes, [&](Edge &e) {
+    if (k == edges.keys.size())
+      return false;
+    e = edges.decode(edges.keys[k++]);
+    return true;
+  });
+
+  aoc::io::out() << ans << std::endl;
+}
+
+// Static 3D k-d tree. The tree is implicit: idx is reordered so that every
+// subtree is a contiguous range [lo, hi) split at mid = (lo + hi) / 2 on axis
+// depth % 3.
+class KdTree {
+public:
+  using Neighbour = std::pair<long long, int>; // (squared distance, box)
+
+  explicit KdTree(std::span<const Box> boxes) : boxes(boxes) {
+    idx.resize(boxes.size());
+    for (size_t i = 0; i < idx.size(); ++i)
+      idx[i] = i;
+    build(0, idx.size(), 0);
+  }
+
+  // The k nearest boxes to box p (p excluded), ordered by (distance, index).
+  // Ties are broken by index so that a larger query always extends a smaller
+  // one.
+  std::vector<Neighbour> nearest(int p, size_t k) const {
+    std::vector<Neighbour> heap; // max-heap of the best k so far
+    heap.reserve(k + 1);
+    search(0, idx.size(), 0, p, k, heap);
+    std::sort_heap(heap.begin(), heap.end());
+    return heap;
+  }
+
+private:
+  std::span<const Box> boxes;
+  std::vector<int> idx;
+
+  void build(int lo, int hi, int axis) {
+    if (hi - lo <= 1)
+      return;
+    int mid = (lo + hi) / 2;
+    std::nth_element(idx.begin() + lo, idx.begin() + mid, idx.begin() + hi,
+                     [&](int a, int b) {
+                       return coord(boxes[a], axis) < coord(boxes[b], axis);
+                     });
+    build(lo, mid, (axis + 1) % 3);
+    build(mid + 1, hi, (axis + 1) % 3);
+  }
+
+  void search(int lo, int hi, int axis, int p, size_t k,
+              std::vector<Neighbour> &heap) const {
+    if (lo >= hi)
+      return;
+    int mid = (lo + hi) / 2;
+    int q = idx[mid];
+
+    if (q != p) {
+      Neighbour cand{squared_dist(boxes[p], boxes[q]), q};
+      if (heap.size() < k || cand < heap.front()) {
+        heap.push_back(cand);
+        std::push_heap(heap.begin(), heap.end());
+        if (heap.size() > k) {
+          std::pop_heap(heap.begin(), heap.end());
+          heap.pop_back();
+        }
       }
     }
+
+    long long diff = coord(boxes[p], axis) - coord(boxes[q], axis);
+    int next_axis = (axis + 1) % 3;
+    // Visit the side of the splitting plane p is on first
+    if (diff < 0) {
+      search(lo, mid, next_axis, p, k, heap);
+      if (heap.size() < k || diff * diff <= heap.front().first)
+        search(mid + 1, hi, next_axis, p, k, heap);
+    } else {
+      search(mid + 1, hi, next_axis, p, k, heap);
+      if (heap.size() < k || diff * diff <= heap.front().first)
+        search(lo, mid, next_axis, p, k, heap);
+    }
+  }
+};
+
+// Produces the edges of the complete graph lazily, in increasing weight. Each
+// box keeps a sorted list of its nearest neighbours and a cursor into it; a
+// min-heap holds the current candidate of every box, so popping the heap
+// merges the n sorted streams. A list is only re-queried (with twice the k)
+// once its box has used it up, and Kruskal usually stops long before that.
+class NearestEdgeStream {
+public:
+  explicit NearestEdgeStream(std::span<const Box> boxes, size_t k = 8)
+      : tree(boxes), neighbours(boxes.size()), cursor(boxes.size(), 0) {
+    for (int i = 0; i < (int)boxes.size(); ++i) {
+      neighbours[i] = tree.nearest(i, k);
+      push_candidate(i);
+    }
+  }
+
+  bool next(Edge &e) {
+    while (!heap.empty()) {
+      Edge cand = heap.top();
+      heap.pop();
+      cursor[cand.u]++;
+      push_candidate(cand.u);
+      // Every edge shows up in both endpoints' lists, keep only one copy
+      if (cand.u < cand.v) {
+        e = cand;
+        return true;
+      }
+    }
+    return false;
   }
 
-  std::cout << ans << std::endl;
+private:
+  struct Longer {
+    bool operator()(const Edge &a, const Edge &b) const {
+      return std::tie(a.weight, a.u, a.v) > std::tie(b.weight, b.u, b.v);
+    }
+  };
+
+  KdTree tree;
+  std::vector<std::vector<KdTree::Neighbour>> neighbours;
+  std::vector<size_t> cursor;
+  std::priority_queue<Edge, std::vector<Edge>, Longer> heap;
+
+  void push_candidate(int i) {
+    auto &list = neighbours[i];
+    if (cursor[i] == list.size()) {
+      size_t n = cursor.size();
+      if (list.size() + 1 >= n)
+        return; // every other box has been seen already
+      list = tree.nearest(i, std::min(2 * list.size(), n - 1));
+    }
+    const auto &[dist, j] = list[cursor[i]];
+    heap.push({i, j, dist});
+  }
+};
+
+void solve_kdtree(std::span<const Box> boxes) {
+  AOC_PERF_SCOPE("day_08 kdtree", boxes.size());
+  NearestEdgeStream stream(boxes);
+  long long ans =
+      kruskal_last_edge(boxes, [&](Edge &e) { return stream.next(e); });
+  aoc::io::out() << ans << std::endl;
 }
 
-int main() {
-  auto lines = aoc::io::read_lines();
+// Prim engine. The graph is complete, so O(n^2) Prim with a flat min_dist
+// array beats sorting O(n^2) edges: no sort and O(n) memory.
+// The boxes that are not in the tree yet are kept compacted at the front of
+// structure-of-arrays buffers (a box joining the tree is swapped with the
+// last one), so the hot loop streams over contiguous memory with no mask.
+// Coordinates are T and squared distances D: doubles while every squared
+// distance is below 2^53, so they're exact and the SIMD kernel applies,
+// integers wide enough for the bounding box otherwise.
+template <typename T, typename D> struct PrimState {
+  std::vector<T> x, y, z;
+  std::vector<D> min_dist; // distance to the closest box in the tree
+  std::vector<int> id;     // original box index
+  std::vector<int> from;   // closest box in the tree
 
-  solve(lines);
+  void swap_remove(size_t j, size_t last) {
+    std::swap(x[j], x[last]);
+    std::swap(y[j], y[last]);
+    std::swap(z[j], z[last]);
+    std::swap(min_dist[j], min_dist[last]);
+    std::swap(id[j], id[last]);
+    std::swap(from[j], from[last]);
+  }
+};
+
+// For unsigned D the square wraps around, which is still right as long as
+// the sum fits
+template <typename D, typename T> D squared_dist(T dx, T dy, T dz) {
+  return D(dx) * D(dx) + D(dy) * D(dy) + D(dz) * D(dz);
+}
+
+// Relaxes min_dist[0, m) against box u at (ux, uy, uz), which just joined the
+// tree, and returns the position of the closest remaining box.
+template <typename T, typename D>
+size_t relax_scalar(PrimState<T, D> &s, size_t m, T ux, T uy, T uz, int u) {
+  size_t best = 0;
+  for (size_t j = 0; j < m; ++j) {
+    D d = squared_dist<D>(s.x[j] - ux, s.y[j] - uy, s.z[j] - uz);
+    if (d < s.min_dist[j]) {
+      s.min_dist[j] = d;
+      s.from[j] = u;
+    }
+    if (s.min_dist[j] < s.min_dist[best])
+      best = j;
+  }
+  return best;
+}
+
+#if defined(__x86_64__)
+// Same as relax_scalar, 4 doubles per AVX2 register and the loop unrolled
+// twice, so 8 boxes per iteration.
+// The running minimum and its position are tracked per lane and reduced at
+// the end.
+__attribute__((target("avx2,fma"))) size_t
+relax_avx2(PrimState<double, double> &s, size_t m, double ux, double uy,
+           double uz, int u) {
+  const __m256d vx = _mm256_set1_pd(ux);
+  const __m256d vy = _mm256_set1_pd(uy);
+  const __m256d vz = _mm256_set1_pd(uz);
+  const __m256d step = _mm256_set1_pd(4.0);
+
+  __m256d best_val = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+  __m256d best_pos = _mm256_set1_pd(-1.0);
+  __m256d pos = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+
+  size_t j = 0;
+#pragma GCC unroll 2
+  for (; j + 4 <= m; j += 4) {
+    __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&s.x[j]), vx);
+    __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&s.y[j]), vy);
+    __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(&s.z[j]), vz);
+    __m256d d = _mm256_mul_pd(dx, dx);
+    d = _mm256_fmadd_pd(dy, dy, d);
+    d = _mm256_fmadd_pd(dz, dz, d);
+
+    __m256d cur = _mm256_loadu_pd(&s.min_dist[j]);
+    __m256d closer = _mm256_cmp_pd(d, cur, _CMP_LT_OQ);
+    // Parents only change while the tree is small, so a branch is cheap here
+    if (int mask = _mm256_movemask_pd(closer)) {
+      for (int b = 0; b < 4; ++b)
+        if (mask & (1 << b))
+          s.from[j + b] = u;
+      cur = _mm256_min_pd(d, cur);
+      _mm256_storeu_pd(&s.min_dist[j], cur);
+    }
+
+    __m256d better = _mm256_cmp_pd(cur, best_val, _CMP_LT_OQ);
+    best_val = _mm256_blendv_pd(best_val, cur, better);
+    best_pos = _mm256_blendv_pd(best_pos, pos, better);
+    pos = _mm256_add_pd(pos, step);
+  }
+
+  alignas(32) double vals[4], poss[4];
+  _mm256_store_pd(vals, best_val);
+  _mm256_store_pd(poss, best_pos);
+  size_t best = 0;
+  double best_dist = std::numeric_limits<double>::infinity();
+  for (int b = 0; b < 4; ++b) {
+    if (poss[b] >= 0 && vals[b] < best_dist) {
+      best_dist = vals[b];
+      best = poss[b];
+    }
+  }
+
+  // Scalar tail
+  for (; j < m; ++j) {
+    double d = squared_dist<double>(s.x[j] - ux, s.y[j] - uy, s.z[j] - uz);
+    if (d < s.min_dist[j]) {
+      s.min_dist[j] = d;
+      s.from[j] = u;
+    }
+    if (s.min_dist[j] < best_dist) {
+      best_dist = s.min_dist[j];
+      best = j;
+    }
+  }
+  return best;
+}
+#endif
+
+// Kruskal joins the last two components with the heaviest edge of the MST, so
+// the answer is the product of the x coordinates of that edge.
+template <typename T, typename D>
+long long prim_last_edge(std::span<const Box> boxes, bool simd) {
+  size_t n = boxes.size();
+  PrimState<T, D> s;
+  s.x.resize(n);
+  s.y.resize(n);
+  s.z.resize(n);
+  s.min_dist.assign(n, std::numeric_limits<D>::max());
+  s.id.resize(n);
+  s.from.assign(n, -1);
+  for (size_t i = 0; i < n; ++i) {
+    s.x[i] = boxes[i].x;
+    s.y[i] = boxes[i].y;
+    s.z[i] = boxes[i].z;
+    s.id[i] = i;
+  }
+
+  auto relax = relax_scalar<T, D>;
+#if defined(__x86_64__)
+  if constexpr (std::is_same_v<D, double>)
+    if (simd && __builtin_cpu_supports("avx2") &&
+        __builtin_cpu_supports("fma"))
+      relax = relax_avx2;
+#endif
+  (void)simd;
+
+  // Start the tree from the last box
+  size_t m = n - 1;
+  int u = s.id[m];
+  T ux = s.x[m], uy = s.y[m], uz = s.z[m];
+
+  D heaviest = 0;
+  long long ans = 1;
+  for (bool first = true; m > 0; first = false) {
+    size_t j = relax(s, m, ux, uy, uz, u);
+    if (first || s.min_dist[j] > heaviest) {
+      heaviest = s.min_dist[j];
+      ans = (long long)boxes[s.from[j]].x * boxes[s.id[j]].x;
+    }
+    u = s.id[j];
+    ux = s.x[j];
+    uy = s.y[j];
+    uz = s.z[j];
+    s.swap_remove(j, --m);
+  }
+  return ans;
+}
+
+void solve_prim(std::span<const Box> boxes, bool simd) {
+  size_t n = boxes.size();
+  if (n < 2) { // no edge at all, same answer as the other engines
+    aoc::io::out() << 1 << std::endl;
+    return;
+  }
+  AOC_PERF_SCOPE("day_08 prim", row_offset(n, n));
+  u128 max_dist = max_squared_dist(boxes);
+  long long ans;
+  if (max_dist <= u128(1) << 53)
+    ans = prim_last_edge<double, double>(boxes, simd);
+  else if (max_dist <= std::numeric_limits<uint64_t>::max())
+    ans = prim_last_edge<long long, uint64_t>(boxes, simd);
+  else
+    ans = prim_last_edge<long long, u128>(boxes, simd);
+  aoc::io::out() << ans << std::endl;
+}
+
+// Entry point for the multi-day runner: default engine, no cache
+void solve(std::string_view input) {
+  solve(parse_boxes(aoc::io::split_lines(input)));
+}
+
+[[maybe_unused]] const bool registered = aoc::register_day(8, solve);
+
+} // namespace day_08
+
+#ifndef AOC_RUNNER
+int main(int argc, char **argv) {
+  using namespace day_08;
+
+  // Optional engine: "kdtree" streams edges from nearest neighbour queries
+  // instead of materialising and sorting all n(n-1)/2 of them, "prim" runs
+  // dense Prim with SIMD distances ("prim-scalar" without).
+  // "parallel" builds and radix sorts all the edges on every core.
+  // "part1 [K]" connects the K (1000 by default) closest pairs instead.
+  std::string_view engine = argc > 1 ? argv[1] : "kruskal";
+
+  auto store = aoc::cache::Store::open("day_08 boxes v1");
+  std::vector<Box> parsed;
+  if (!store.hit()) {
+    AOC_ALLOC_PHASE("read");
+    auto lines = aoc::io::read_lines();
+    AOC_ALLOC_PHASE("parse");
+    parsed = parse_boxes(lines);
+    store.put(parsed);
+    store.save();
+  }
+  auto boxes = store.get<Box>(0);
+
+  AOC_ALLOC_PHASE("solve");
+  if (engine == "part1")
+    solve_part1(boxes, argc > 2 ? std::stoul(argv[2]) : 1000);
+  else if (engine == "parallel")
+    solve_parallel(boxes);
+  else if (engine == "kdtree")
+    solve_kdtree(boxes);
+  else if (engine == "prim" || engine == "prim-scalar")
+    solve_prim(boxes, engine == "prim");
+  else
+    solve(boxes);
 
   return 0;
 }
+#endif
 
 /** Notes
  *
@@ -118,4 +695,42 @@ int main() {
  * the implementation becomes more complex because we need to catch the moment
  * when we have only one connected component (because the result is a product
  * between the last two components).
+ *
+ * Materialising every edge doesn't scale: 100k boxes means 5 billion edges.
+ * Kruskal only needs the edges in increasing order, and only until the graph
+ * is connected, which usually happens long before we get to the far pairs.
+ * With a k-d tree we can ask each box for its k nearest neighbours; the
+ * sorted neighbour lists are n sorted streams of edges, and a min-heap merges
+ * them lazily. When a box runs out of neighbours, we query it again with 2k.
+ *
+ * TC: O(n log n) -> building the tree and the queries on realistic point
+ * clouds, plus O(log n) per edge pulled from the heap
+ * SC: O(n * k)
+ *
+ * About Prim: on a complete graph the textbook O(n^2) Prim (no heap, just a
+ * min_dist array scanned at every step) is actually the better choice:
+ * it needs no sort and O(n) memory, and the scan is a perfect fit for SIMD
+ * once the coordinates are stored as x[], y[], z[]. The last edge Kruskal adds
+ * is the heaviest edge of the MST, so we just track the maximum.
+ *
+ * TC: O(n^2) -> no log factor
+ * SC: O(n)
+ *
+ * Back to part 1: we only need the first 1000 connections, so sorting every
+ * edge is a waste. A max-heap bounded to K elements keeps the K best seen so
+ * far: anything longer than the top is rejected with one comparison. Each
+ * thread scans its own tiles of rows with its own heap, and the T * K
+ * survivors are merged with nth_element.
+ *
+ * TC: O(n^2 + m log K) -> m edges get into a heap, usually a tiny fraction
+ * SC: O(K) per thread
+ *
+ * The all-pairs Kruskal can also simply use more cores. The edge count is
+ * known upfront, so every thread can fill its own slice of one buffer. If the
+ * edge is packed as dist | u | v in a 64-bit key, comparing keys compares
+ * distances, and an LSD radix sort (parallel histograms + scatter) replaces
+ * std::sort on the 24-byte structs.
+ *
+ * TC: O(n^2 * passes / threads)
+ * SC: O(n^2) -> 8 bytes per edge, twice for the radix buffer
  */
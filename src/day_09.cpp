@@ -1,155 +1,821 @@
+#include "shared/alloc.hpp"
+#include "shared/cache.hpp"
 #include "shared/io.hpp"
+#include "shared/parallel.hpp"
+#include "shared/perf.hpp"
+#include "shared/registry.hpp"
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cstdint>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <new>
+#include <span>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <vector>
 
+namespace day_09 {
+
 struct Point {
   int x;
   int y;
 };
 
-void part1(const std::vector<std::string> &lines) {
+// The red tiles, in order around the loop
+struct Polygon {
   std::vector<Point> points;
-  for (auto &line : lines) {
-    std::istringstream iss(line);
-    Point p;
-    char c; // comma
-    iss >> p.x >> c >> p.y;
-    points.push_back(p);
+
+  static Polygon parse(const std::vector<std::string> &lines) {
+    Polygon polygon;
+    for (auto &line : lines) {
+      std::istringstream iss(line);
+      Point p;
+      char c; // comma
+      iss >> p.x >> c >> p.y;
+      polygon.points.push_back(p);
+    }
+    return polygon;
   }
+};
+
+long long rect_area(const Point &a, const Point &b) {
+  return (std::abs((long long)a.x - b.x) + 1) *
+         (std::abs((long long)a.y - b.y) + 1);
+}
+
+// Points that no other point beats towards the bottom-left corner (no other
+// point has both x <= and y <=), sorted by x with y strictly decreasing.
+std::vector<Point> lower_staircase(std::vector<Point> points) {
+  std::sort(points.begin(), points.end(), [](const Point &a, const Point &b) {
+    return std::tie(a.x, a.y) < std::tie(b.x, b.y);
+  });
+  std::vector<Point> stairs;
+  for (const auto &p : points)
+    if (stairs.empty() || p.y < stairs.back().y)
+      stairs.push_back(p);
+  return stairs;
+}
 
-  long long ans = 0;
+// Same towards the top-right corner, also sorted by x with y decreasing.
+std::vector<Point> upper_staircase(std::vector<Point> points) {
+  std::sort(points.begin(), points.end(), [](const Point &a, const Point &b) {
+    return std::tie(a.x, a.y) > std::tie(b.x, b.y);
+  });
+  std::vector<Point> stairs;
+  for (const auto &p : points)
+    if (stairs.empty() || p.y > stairs.back().y)
+      stairs.push_back(p);
+  std::reverse(stairs.begin(), stairs.end());
+  return stairs;
+}
 
-  for (size_t i = 0; i < points.size(); ++i) {
-    for (size_t j = i + 1; j < points.size(); ++j) {
-      // area = (x2 - x1 + 1) * (y2 - y1 + 1)
-      long long width = std::abs(points[i].x - points[j].x) + 1;
-      long long height = std::abs(points[i].y - points[j].y) + 1;
-      long long area = width * height;
-      ans = std::max(ans, area);
+// Best upper[j] for every lower[i] in [lo, hi], knowing the best j only moves
+// right as i does (divide and conquer optimisation).
+void best_pairs(const std::vector<Point> &lower,
+                const std::vector<Point> &upper, int lo, int hi, int opt_lo,
+                int opt_hi, long long &best) {
+  if (lo > hi)
+    return;
+  int mid = (lo + hi) / 2;
+  long long mid_best = std::numeric_limits<long long>::min();
+  int opt = opt_lo;
+  for (int j = opt_lo; j <= opt_hi; ++j) {
+    const Point &l = lower[mid], &u = upper[j];
+    // upper[j] below and left of lower[mid]: not a candidate
+    long long area = std::numeric_limits<long long>::min();
+    if (u.x >= l.x || u.y >= l.y)
+      area = ((long long)u.x - l.x + 1) * ((long long)u.y - l.y + 1);
+    if (area > mid_best) {
+      mid_best = area;
+      opt = j;
     }
   }
+  best = std::max(best, mid_best);
+  best_pairs(lower, upper, lo, mid - 1, opt_lo, opt, best);
+  best_pairs(lower, upper, mid + 1, hi, opt, opt_hi, best);
+}
 
-  std::cout << ans << std::endl;
+// Largest rectangle with two of the points as opposite corners.
+long long max_rectangle(std::span<const Point> corners) {
+  std::vector<Point> points(corners.begin(), corners.end());
+  long long best = 0;
+  // Bottom-left/top-right corners first, then mirror y for the other diagonal
+  for (int pass = 0; pass < 2; ++pass) {
+    auto lower = lower_staircase(points);
+    auto upper = upper_staircase(points);
+    best_pairs(lower, upper, 0, lower.size() - 1, 0, upper.size() - 1, best);
+    for (auto &p : points)
+      p.y = -p.y;
+  }
+  return best;
 }
 
-void part2(const std::vector<std::string> &lines) {
-  std::vector<Point> points;
-  for (auto &line : lines) {
-    std::istringstream iss(line);
-    Point p;
-    char c; // comma
-    iss >> p.x >> c >> p.y;
-    points.push_back(p);
+void part1(std::span<const Point> points) {
+  AOC_PERF_SCOPE("day_09 part1", points.size());
+  aoc::io::out() << max_rectangle(points) << std::endl;
+}
+
+// Compressed axis: every distinct coordinate of a red tile gets a cell of
+// width 1 and every gap between two of them a single cell as wide as the gap.
+// One padding cell on each end keeps the border of the grid outside.
+struct Axis {
+  std::vector<int> start;       // first real coordinate of each cell
+  std::vector<long long> width; // number of real tiles in each cell
+
+  Axis() = default;
+
+  explicit Axis(std::vector<int> values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    add(values.front() - 1, 1); // padding
+    for (size_t i = 0; i < values.size(); ++i) {
+      add(values[i], 1);
+      if (i + 1 < values.size() && values[i + 1] > values[i] + 1)
+        add(values[i] + 1, values[i + 1] - values[i] - 1);
+    }
+    add(values.back() + 1, 1); // padding
   }
 
-  int max_w = 0, max_h = 0;
-  for (size_t i = 0; i < points.size(); ++i) {
-    max_w = std::max(max_w, points[i].x);
-    max_h = std::max(max_h, points[i].y);
+  // Cell of a red tile coordinate
+  int cell(int v) const {
+    return std::lower_bound(start.begin(), start.end(), v) - start.begin();
   }
 
-  std::vector<std::vector<int8_t>> grid(
-      max_w + 2, std::vector<int8_t>(max_h + 2, 0)); // 0 means "invalid"
+  int size() const { return start.size(); }
+
+private:
+  void add(int s, long long w) {
+    start.push_back(s);
+    width.push_back(w);
+  }
+};
 
-  // define the boundaries
-  for (size_t i = 0; i < points.size(); ++i) {
-    size_t next_idx = (i + 1) % points.size();
-    Point p1 = points[i];
-    Point p2 = points[next_idx];
+// The tiles of the polygon are exactly the polygon grown by half a tile on
+// every side. In tile-edge coordinates (tile x spans [x, x + 1)) the outline
+// of that shape is the loop of red tiles with every vertical edge moved to x
+// or x + 1 and every horizontal one to y or y + 1, whichever is outside.
+// Edges at neighbouring coordinates can end up on top of each other (a one
+// tile wide gap closes), which is fine as long as we only sum over them.
+struct OutlineEdge {
+  long long x, lo, hi; // spans [lo, hi)
+  int c; // winding number change when crossing it left to right
+};
 
-    if (p1.x == p2.x) {
-      for (int i = std::min(p1.y, p2.y); i <= std::max(p1.y, p2.y); ++i) {
-        grid[p1.x][i] = 1;
-      }
-    } else {
-      for (int i = std::min(p1.x, p2.x); i <= std::max(p1.x, p2.x); ++i) {
-        grid[i][p1.y] = 1;
+// The loop without repeated points, so without zero-length edges
+std::vector<Point> clean_loop(std::span<const Point> points) {
+  std::vector<Point> loop;
+  for (const auto &p : points)
+    if (loop.empty() || p.x != loop.back().x || p.y != loop.back().y)
+      loop.push_back(p);
+  while (loop.size() > 1 && loop.front().x == loop.back().x &&
+         loop.front().y == loop.back().y)
+    loop.pop_back();
+  return loop;
+}
+
+// Vertical edges of the outline, for a loop of at least 4 points. The
+// horizontal ones are the vertical ones of the loop with x and y swapped.
+std::vector<OutlineEdge> vertical_outline(const std::vector<Point> &loop) {
+  size_t n = loop.size();
+  auto at = [&](size_t i) -> const Point & { return loop[i % n]; };
+  auto sign = [](long long v) { return (v > 0) - (v < 0); };
+
+  // The lowest of the leftmost points is a convex corner: its turn gives the
+  // orientation, s = 1 counterclockwise
+  size_t low = std::min_element(loop.begin(), loop.end(),
+                                [](const Point &a, const Point &b) {
+                                  return std::tie(a.x, a.y) <
+                                         std::tie(b.x, b.y);
+                                }) -
+               loop.begin();
+  const Point &prev = at(low + n - 1), &v = at(low), &next = at(low + 1);
+  int turn = sign(v.x - prev.x) * sign(next.y - v.y) -
+             sign(v.y - prev.y) * sign(next.x - v.x);
+  int s = turn > 0 ? 1 : -1;
+
+  // Where the end y of a vertical edge goes, given the other edge there.
+  // Outside is right of the direction of travel when s = 1.
+  auto moved_y = [&](const Point &from, const Point &to, int y) {
+    if (from.y != to.y)
+      return (long long)y; // vertical too: a straight joint stays put
+    return y + ((to.x > from.x) == (s > 0) ? 0LL : 1LL);
+  };
+
+  std::vector<OutlineEdge> edges;
+  for (size_t i = 0; i < n; ++i) {
+    const Point &a = at(i), &b = at(i + 1);
+    if (a.x != b.x)
+      continue;
+    long long x = a.x + ((b.y > a.y) == (s > 0) ? 1LL : 0LL);
+    long long ya = moved_y(at(i + n - 1), a, a.y);
+    long long yb = moved_y(b, at(i + 2), b.y);
+    if (ya != yb)
+      edges.push_back(
+          {x, std::min(ya, yb), std::max(ya, yb), s * (b.y < a.y ? 1 : -1)});
+  }
+  return edges;
+}
+
+// For every point, how many tiles its row stays on the polygon to its left
+// and to its right. One sweep over the rows: the outline edges crossing the
+// current row sit in a map by x, with their winding changes summed, so the
+// tiles covered are the runs between consecutive keys, alternately.
+std::vector<std::pair<long long, long long>>
+row_runs(std::span<const Point> points,
+         const std::vector<OutlineEdge> &edges) {
+  std::vector<int> order(points.size());
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(),
+            [&](int a, int b) { return points[a].y < points[b].y; });
+  std::vector<const OutlineEdge *> by_lo, by_hi;
+  for (const auto &e : edges) {
+    by_lo.push_back(&e);
+    by_hi.push_back(&e);
+  }
+  std::sort(by_lo.begin(), by_lo.end(),
+            [](auto a, auto b) { return a->lo < b->lo; });
+  std::sort(by_hi.begin(), by_hi.end(),
+            [](auto a, auto b) { return a->hi < b->hi; });
+
+  std::map<long long, int> crossing;
+  auto change = [&](long long x, int c) {
+    if ((crossing[x] += c) == 0)
+      crossing.erase(x);
+  };
+  std::vector<std::pair<long long, long long>> runs(points.size());
+  size_t added = 0, removed = 0;
+  for (int i : order) {
+    const Point &p = points[i];
+    // Tile row y is crossed by the edges with lo <= y < hi
+    for (; added < by_lo.size() && by_lo[added]->lo <= p.y; ++added)
+      change(by_lo[added]->x, by_lo[added]->c);
+    for (; removed < by_hi.size() && by_hi[removed]->hi <= p.y; ++removed)
+      change(by_hi[removed]->x, -by_hi[removed]->c);
+    // p is on the polygon, so it's between an opening and a closing edge
+    auto end = crossing.upper_bound(p.x);
+    if (end == crossing.end() || end == crossing.begin())
+      continue; // not a simple polygon
+    runs[i] = {p.x - std::prev(end)->first, end->first - 1 - p.x};
+  }
+  return runs;
+}
+
+// How far a rectangle with a red tile as corner can reach in each direction:
+// the side along its row (column) has to stay on the polygon.
+struct Reach {
+  long long left = 0, right = 0, down = 0, up = 0;
+};
+
+std::vector<Reach> reach(std::span<const Point> points) {
+  std::vector<Reach> reach(points.size());
+  auto loop = clean_loop(points);
+  if (loop.size() < 4) { // a single segment: nothing to prune
+    for (size_t i = 0; i < points.size(); ++i)
+      for (const auto &q : points) {
+        long long dx = q.x - (long long)points[i].x;
+        long long dy = q.y - (long long)points[i].y;
+        reach[i].left = std::max(reach[i].left, -dx);
+        reach[i].right = std::max(reach[i].right, dx);
+        reach[i].down = std::max(reach[i].down, -dy);
+        reach[i].up = std::max(reach[i].up, dy);
       }
-    }
+    return reach;
   }
 
-  // flood fill the grid using BFS
-  std::queue<Point> q;
-  q.push({0, 0});
+  auto rows = row_runs(points, vertical_outline(loop));
+  auto swapped = [](std::span<const Point> points) {
+    std::vector<Point> v(points.begin(), points.end());
+    for (auto &p : v)
+      std::swap(p.x, p.y);
+    return v;
+  };
+  auto cols = row_runs(swapped(points), vertical_outline(swapped(loop)));
+  for (size_t i = 0; i < points.size(); ++i)
+    reach[i] = {rows[i].first, rows[i].second, cols[i].first,
+                cols[i].second};
+  return reach;
+}
+
+// Branch and bound over the pairs. A rectangle with corner p opening towards
+// one quadrant can't be wider or taller than p's reach that way, so every
+// (corner, quadrant) gets that bound, they're visited largest bound first and
+// the search stops once the bound can't beat the best valid area. Partners
+// are the points inside the reach, scanned from the far side in x and only
+// while they're far enough to still win; they have to reach back to p too.
+template <typename Valid>
+long long max_valid_rectangle(std::span<const Point> points,
+                              const std::vector<Reach> &reach, Valid valid) {
+  int n = points.size();
+  struct Candidate {
+    long long bound;
+    int i, sx, sy; // corner and quadrant
+  };
+  std::vector<Candidate> candidates;
+  for (int i = 0; i < n; ++i)
+    for (int sx : {-1, 1})
+      for (int sy : {-1, 1}) {
+        long long w = sx > 0 ? reach[i].right : reach[i].left;
+        long long h = sy > 0 ? reach[i].up : reach[i].down;
+        candidates.push_back({(w + 1) * (h + 1), i, sx, sy});
+      }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate &a, const Candidate &b) {
+              return a.bound > b.bound;
+            });
+
+  std::vector<int> by_x(n);
+  for (int i = 0; i < n; ++i)
+    by_x[i] = i;
+  std::sort(by_x.begin(), by_x.end(),
+            [&](int a, int b) { return points[a].x < points[b].x; });
+  std::vector<long long> xs(n);
+  for (int k = 0; k < n; ++k)
+    xs[k] = points[by_x[k]].x;
 
-  while (!q.empty()) {
-    int sz = q.size();
-    while (sz--) {
-      Point p = q.front();
-      q.pop();
-      if (grid[p.x][p.y] == 1)
+  long long best = 0;
+  for (const auto &[bound, i, sx, sy] : candidates) {
+    if (bound <= best)
+      break;
+    const Point &p = points[i];
+    long long w = sx > 0 ? reach[i].right : reach[i].left;
+    long long h = sy > 0 ? reach[i].up : reach[i].down;
+    // Partners with x in [p.x, p.x + w], or mirrored, far side first
+    long long near = p.x, far = p.x + sx * w;
+    int lo = std::lower_bound(xs.begin(), xs.end(), std::min(near, far)) -
+             xs.begin();
+    int hi = std::upper_bound(xs.begin(), xs.end(), std::max(near, far)) -
+             xs.begin();
+    for (int k = 0; k < hi - lo; ++k) {
+      int j = by_x[sx > 0 ? hi - 1 - k : lo + k];
+      const Point &q = points[j];
+      long long dx = std::abs((long long)q.x - p.x);
+      if ((dx + 1) * (h + 1) <= best)
+        break;
+      long long dy = ((long long)q.y - p.y) * sy;
+      if (dy < 0 || dy > h)
         continue;
-      else if (grid[p.x][p.y] == 2)
+      // q is the opposite corner, the rectangle opens the other way from it
+      if (dx > (sx > 0 ? reach[j].left : reach[j].right) ||
+          dy > (sy > 0 ? reach[j].down : reach[j].up))
         continue;
-      grid[p.x][p.y] = 2; // 2 means "visited"
+      long long area = rect_area(p, q);
+      if (area > best && valid(p, q))
+        best = area;
+    }
+  }
+  return best;
+}
 
-      if (p.x > 0)
-        q.push({p.x - 1, p.y});
-      if (p.x < max_w + 1)
-        q.push({p.x + 1, p.y});
-      if (p.y > 0)
-        q.push({p.x, p.y - 1});
-      if (p.y < max_h + 1)
-        q.push({p.x, p.y + 1});
+// Exhaustive search on every core. The pair triangle (i, j > i) is cut into
+// blocks of rows holding about the same number of pairs, handed out through
+// an atomic counter. Threads share the best area found so far and skip any
+// pair that can't beat it before touching the prefix sums; the read is
+// relaxed since a stale value only costs a few extra checks. The result is a
+// max over thread-local bests, so it doesn't depend on the scheduling.
+template <typename Valid>
+long long max_valid_rectangle_parallel(std::span<const Point> points,
+                                       Valid valid, int threads) {
+  size_t n = points.size();
+  size_t blocks = std::min<size_t>(n, threads * 16);
+
+  // Block b covers rows [first_row[b], first_row[b + 1])
+  size_t total = n * (n - 1) / 2;
+  std::vector<size_t> first_row{0};
+  size_t pairs = 0;
+  for (size_t i = 0; i < n && first_row.size() < blocks; ++i) {
+    pairs += n - 1 - i;
+    if (pairs >= total * first_row.size() / blocks)
+      first_row.push_back(i + 1);
+  }
+  first_row.push_back(n);
+
+  std::atomic<size_t> next_block{0};
+  std::atomic<long long> shared_best{0};
+  std::vector<long long> local_best(threads, 0);
+
+  aoc::run_threads(threads, [&](int t) {
+    long long best = 0;
+    for (size_t b; (b = next_block.fetch_add(1)) + 1 < first_row.size();) {
+      for (size_t i = first_row[b]; i < first_row[b + 1]; ++i) {
+        for (size_t j = i + 1; j < n; ++j) {
+          long long area = rect_area(points[i], points[j]);
+          if (area <= best ||
+              area <= shared_best.load(std::memory_order_relaxed))
+            continue;
+          if (!valid(points[i], points[j]))
+            continue;
+          best = area;
+          long long seen = shared_best.load(std::memory_order_relaxed);
+          while (seen < best && !shared_best.compare_exchange_weak(
+                                    seen, best, std::memory_order_relaxed))
+            ;
+        }
+      }
+    }
+    local_best[t] = best;
+  });
+
+  return *std::max_element(local_best.begin(), local_best.end());
+}
+
+// Everything part 2 needs to check a rectangle in O(1), built once per
+// polygon: the compressed axes, which compressed cells are inside (or on the
+// boundary), and the prefix sums of the real area of those cells.
+struct PolygonIndex {
+  Axis ax, ay;
+  std::vector<int8_t> inside;        // row-major: cell (x, y) at y * w + x
+  std::vector<long long> prefix_sum; // row-major, (w + 1) * (h + 1)
+
+  PolygonIndex() = default;
+
+  explicit PolygonIndex(const Polygon &polygon) {
+    const auto &points = polygon.points;
+    std::vector<int> xs, ys;
+    for (const auto &p : points) {
+      xs.push_back(p.x);
+      ys.push_back(p.y);
+    }
+    ax = Axis(xs);
+    ay = Axis(ys);
+    // Up to (2n + 1)^2 cells: the flat indices don't fit in an int past ~23k
+    // red tiles, and the grid itself may not fit in memory at all
+    size_t w = ax.size(), h = ay.size();
+    AOC_PERF_SCOPE("day_09 rasterise", w * h);
+
+    // Vertical edges as parity toggles: an edge from row y1 to row y2 crosses
+    // the half-open rows [y1, y2), so it flips the column at y1 and flips it
+    // back at y2. XOR-ing the rows top to bottom gives the edges crossing each
+    // row.
+    std::vector<int8_t> toggle;
+    try {
+      inside.assign(w * h, 0);
+      toggle.assign(w * h, 0);
+      prefix_sum.assign((w + 1) * (h + 1), 0);
+    } catch (const std::bad_alloc &) {
+      throw std::runtime_error("day_09: can't allocate the " +
+                               std::to_string(w) + " x " + std::to_string(h) +
+                               " compressed grid");
+    }
+
+    // define the boundaries
+    for (size_t i = 0; i < points.size(); ++i) {
+      size_t next_idx = (i + 1) % points.size();
+      size_t x1 = ax.cell(points[i].x), y1 = ay.cell(points[i].y);
+      size_t x2 = ax.cell(points[next_idx].x),
+             y2 = ay.cell(points[next_idx].y);
+
+      if (x1 == x2) {
+        for (size_t y = std::min(y1, y2); y <= std::max(y1, y2); ++y)
+          inside[y * w + x1] = 1;
+        toggle[std::min(y1, y2) * w + x1] ^= 1;
+        toggle[std::max(y1, y2) * w + x1] ^= 1;
+      } else {
+        for (size_t x = std::min(x1, x2); x <= std::max(x1, x2); ++x)
+          inside[y1 * w + x] = 1;
+      }
+    }
+
+    // Classify each row in one sweep: a cell is inside if an odd number of
+    // vertical edges crosses the row to its left. Cells on a horizontal edge
+    // are already boundary, so the half-open rule only decides the others, for
+    // which row y and row y + epsilon agree.
+    std::vector<int8_t> crossing(w, 0);
+    for (size_t y = 0; y < h; ++y) {
+      int8_t in = 0;
+      for (size_t x = 0; x < w; ++x) {
+        crossing[x] ^= toggle[y * w + x];
+        inside[y * w + x] |= in;
+        in ^= crossing[x];
+      }
+    }
+
+    // Each cell counts for the number of real tiles it covers
+    for (size_t y = 1; y <= h; ++y) {
+      long long row_sum = 0;
+      for (size_t x = 1; x <= w; ++x) {
+        row_sum +=
+            inside[(y - 1) * w + x - 1] * ax.width[x - 1] * ay.width[y - 1];
+        prefix_sum[y * (w + 1) + x] =
+            prefix_sum[(y - 1) * (w + 1) + x] + row_sum;
+      }
     }
   }
 
-  // grid cleanup
-  for (int x = 0; x <= max_w + 1; ++x) {
-    for (int y = 0; y <= max_h + 1; ++y) {
-      if (grid[x][y] == 2)
-        grid[x][y] = 0; // outside -> invalid
-      else if (grid[x][y] == 0)
-        grid[x][y] = 1; // inside (or boundary) -> valid
+  // A rectangle is valid if the area inside it equals its area
+  bool valid(const Point &a, const Point &b) const {
+    int x1 = ax.cell(std::min(a.x, b.x)), x2 = ax.cell(std::max(a.x, b.x));
+    int y1 = ay.cell(std::min(a.y, b.y)), y2 = ay.cell(std::max(a.y, b.y));
+    long long sum =
+        at(x2 + 1, y2 + 1) - at(x1, y2 + 1) - at(x2 + 1, y1) + at(x1, y1);
+    return sum == rect_area(a, b);
+  }
+
+private:
+  long long at(size_t x, size_t y) const {
+    return prefix_sum[y * (ax.size() + 1) + x];
+  }
+};
+
+// The same check without the grid, in O(n log n) memory. The winding number
+// of the outline (see OutlineEdge) is 1 on the tiles and 0 elsewhere, and at
+// any point it's a sum over the vertical edges to its left, so the covered
+// area left of X and below Y is
+//   sum over edges e with x_e < X of c_e * (X - x_e) * (min(hi_e, Y) -
+//   min(lo_e, Y))
+// Every edge end is a point update of a persistent segment tree over the
+// ends' y, one version per edge in x order, and the sum above is one prefix
+// query on the version for X.
+class AreaIndex {
+public:
+  // Per tree node, over the edge ends (x, t) below it with weight k
+  struct Sums {
+    uint64_t k = 0, kt = 0, kx = 0, kxt = 0;
+
+    Sums &operator+=(const Sums &o) {
+      k += o.k;
+      kt += o.kt;
+      kx += o.kx;
+      kxt += o.kxt;
+      return *this;
     }
+  };
+
+  struct Node {
+    uint32_t left = 0, right = 0; // node 0 is the empty tree
+    Sums sums;
+  };
+
+  // Either the vectors below or a cache mapping
+  std::span<const long long> xs;   // x of every edge, sorted
+  std::span<const long long> ys;   // y of every edge end, sorted, distinct
+  std::span<const Node> nodes;     // every version's nodes
+  std::span<const uint32_t> roots; // roots[v]: tree of the first v edges
+
+  AreaIndex() = default;
+  AreaIndex(const AreaIndex &) = delete;
+  AreaIndex &operator=(const AreaIndex &) = delete;
+  // Moving a vector keeps its buffer, so the spans stay valid
+  AreaIndex(AreaIndex &&) = default;
+  AreaIndex &operator=(AreaIndex &&) = default;
+
+  AreaIndex(std::span<const long long> xs, std::span<const long long> ys,
+            std::span<const Node> nodes, std::span<const uint32_t> roots)
+      : xs(xs), ys(ys), nodes(nodes), roots(roots) {}
+
+  explicit AreaIndex(std::span<const Point> points) {
+    build(clean_loop(points));
+    xs = own_xs;
+    ys = own_ys;
+    nodes = own_nodes;
+    roots = own_roots;
   }
 
-  std::vector<std::vector<long long>> prefix_sum(
-      max_w + 3, std::vector<long long>(max_h + 3, 0));
+  // A rectangle is valid if the area inside it equals its area
+  bool valid(const Point &a, const Point &b) const {
+    if (xs.empty())
+      return true; // a single segment, build() added no edges
+    long long x1 = std::min(a.x, b.x), x2 = std::max(a.x, b.x) + 1LL;
+    long long y1 = std::min(a.y, b.y), y2 = std::max(a.y, b.y) + 1LL;
+    uint64_t area = area_below(x2, y2) - area_below(x1, y2) -
+                    area_below(x2, y1) + area_below(x1, y1);
+    return area == uint64_t(rect_area(a, b));
+  }
+
+private:
+  // Sums wrap around, but the differences taken in valid() are areas of a
+  // rectangle, which fit
+  uint64_t area_below(long long x, long long y) const {
+    uint32_t root = roots[std::lower_bound(xs.begin(), xs.end(), x) -
+                          xs.begin()];
+    size_t ends = std::upper_bound(ys.begin(), ys.end(), y) - ys.begin();
+    Sums below = prefix(root, ends);
+    const Sums &all = nodes[root].sums;
+    // Ends above y count as if they were at y
+    uint64_t kt = below.kt + uint64_t(y) * (all.k - below.k);
+    uint64_t kxt = below.kxt + uint64_t(y) * (all.kx - below.kx);
+    return uint64_t(x) * kt - kxt;
+  }
 
-  for (int i = 1; i <= max_w + 2; ++i) {
-    for (int j = 1; j <= max_h + 2; ++j) {
-      long long curr = grid[i - 1][j - 1];
-      prefix_sum[i][j] = prefix_sum[i - 1][j] + prefix_sum[i][j - 1] -
-                         prefix_sum[i - 1][j - 1] + curr;
+  // Sums of the first `ends` leaves
+  Sums prefix(uint32_t node, size_t ends) const {
+    Sums sum;
+    size_t lo = 0, hi = ys.size();
+    while (node != 0 && ends > lo) {
+      if (ends >= hi) {
+        sum += nodes[node].sums;
+        break;
+      }
+      size_t mid = (lo + hi) / 2;
+      if (ends > mid) {
+        sum += nodes[nodes[node].left].sums;
+        node = nodes[node].right;
+        lo = mid;
+      } else {
+        node = nodes[node].left;
+        hi = mid;
+      }
     }
+    return sum;
   }
 
-  long long ans = 0;
-  // iterate through all the pairs of red points and calculate the area
-  // if the sum equals the area, the rectangle is valid
-  for (size_t i = 0; i < points.size(); i++) {
-    for (size_t j = i + 1; j < points.size(); j++) {
-      long long area = (std::abs(points[i].x - points[j].x) + 1) *
-                       (std::abs(points[i].y - points[j].y) + 1);
+  void build(const std::vector<Point> &loop) {
+    AOC_PERF_SCOPE("day_09 area index", loop.size());
+    own_nodes.push_back({});
+    own_roots.push_back(0);
+    if (loop.size() < 4)
+      return; // a single segment: every pair is on the boundary
 
-      long long x1 = std::min(points[i].x, points[j].x);
-      long long x2 = std::max(points[i].x, points[j].x);
-      long long y1 = std::min(points[i].y, points[j].y);
-      long long y2 = std::max(points[i].y, points[j].y);
+    auto edges = vertical_outline(loop);
+    std::sort(edges.begin(), edges.end(),
+              [](const OutlineEdge &a, const OutlineEdge &b) {
+                return a.x < b.x;
+              });
+    for (const auto &e : edges) {
+      own_ys.push_back(e.lo);
+      own_ys.push_back(e.hi);
+    }
+    std::sort(own_ys.begin(), own_ys.end());
+    own_ys.erase(std::unique(own_ys.begin(), own_ys.end()), own_ys.end());
 
-      long long sum = prefix_sum[x2 + 1][y2 + 1] - prefix_sum[x1][y2 + 1] -
-                      prefix_sum[x2 + 1][y1] + prefix_sum[x1][y1];
+    own_nodes.reserve(1 + 2 * edges.size() *
+                              (std::bit_width(own_ys.size()) + 1));
+    for (const auto &e : edges) {
+      uint32_t root = add(own_roots.back(), e.x, e.hi, e.c);
+      own_roots.push_back(add(root, e.x, e.lo, -e.c));
+      own_xs.push_back(e.x);
+    }
+  }
 
-      if (sum == area)
-        ans = std::max(ans, area);
+  // New version of the tree with weight k added at end (x, t)
+  uint32_t add(uint32_t root, long long x, long long t, int k) {
+    size_t leaf =
+        std::lower_bound(own_ys.begin(), own_ys.end(), t) - own_ys.begin();
+    Sums delta{uint64_t(k), uint64_t(k * t), uint64_t(k * x),
+               uint64_t(k * x) * uint64_t(t)};
+    uint32_t copy = own_nodes.size();
+    own_nodes.push_back(own_nodes[root]);
+    own_nodes[copy].sums += delta;
+    // Copy the path down to the leaf, sharing everything else
+    size_t lo = 0, hi = own_ys.size();
+    for (uint32_t node = copy; hi - lo > 1;) {
+      size_t mid = (lo + hi) / 2;
+      bool right = leaf >= mid;
+      uint32_t child = right ? own_nodes[node].right : own_nodes[node].left;
+      uint32_t child_copy = own_nodes.size();
+      own_nodes.push_back(own_nodes[child]);
+      own_nodes[child_copy].sums += delta;
+      (right ? own_nodes[node].right : own_nodes[node].left) = child_copy;
+      node = child_copy;
+      (right ? lo : hi) = mid;
     }
+    return copy;
   }
 
-  std::cout << ans << std::endl;
+  std::vector<long long> own_xs, own_ys;
+  std::vector<Node> own_nodes;
+  std::vector<uint32_t> own_roots;
+};
+
+// The polygon and its index as cache sections, so they can be saved to (and
+// mapped back from) a binary file instead of parsing and rasterising again.
+constexpr std::string_view INDEX_TAG = "day_09 area index v2";
+
+void put_index(aoc::cache::Store &store, std::span<const Point> points,
+               const AreaIndex &index) {
+  store.put(points);
+  store.put(index.xs);
+  store.put(index.ys);
+  store.put(index.nodes);
+  store.put(index.roots);
 }
 
-int main() {
-  auto lines = aoc::io::read_lines();
+// Straight into the mapping, which has to outlive points and index
+void get_index(const aoc::cache::Store &store,
+               std::span<const Point> &points, AreaIndex &index) {
+  points = store.get<Point>(0);
+  index = AreaIndex(store.get<long long>(1), store.get<long long>(2),
+                    store.get<AreaIndex::Node>(3), store.get<uint32_t>(4));
+}
+
+template <typename Index>
+void part2(std::span<const Point> points, const Index &index,
+           bool parallel) {
+  AOC_PERF_SCOPE("day_09 part2", points.size());
+  auto valid = [&](const Point &a, const Point &b) {
+    return index.valid(a, b);
+  };
+
+  if (parallel)
+    aoc::io::out() << max_valid_rectangle_parallel(points, valid,
+                                                   aoc::thread_count())
+                   << std::endl;
+  else
+    aoc::io::out() << max_valid_rectangle(points, reach(points), valid)
+                   << std::endl;
+}
+
+// Entry point for the multi-day runner: default engine, no cache
+void solve(std::string_view input) {
+  Polygon polygon = Polygon::parse(aoc::io::split_lines(input));
+  AreaIndex index(polygon.points);
+  part1(polygon.points);
+  // The reach bounds prune far more than the exhaustive search can gain from
+  // the runner's cores
+  part2(polygon.points, index, false);
+}
+
+[[maybe_unused]] const bool registered = aoc::register_day(9, solve);
+
+} // namespace day_09
+
+#ifndef AOC_RUNNER
+int main(int argc, char **argv) {
+  using namespace day_09;
+
+  // Optional flags:
+  //   parallel   run the exhaustive part 2 search on every core
+  //   dense      check part 2 rectangles on the compressed grid, O(n^2)
+  //              memory, instead of the area index
+  //   save FILE  store the parsed polygon and its index in FILE
+  //   load FILE  start from such a file instead of parsing stdin
+  bool parallel = false, dense = false;
+  std::string save_path, load_path;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "parallel")
+      parallel = true;
+    else if (arg == "dense")
+      dense = true;
+    else if (arg == "save" && i + 1 < argc)
+      save_path = argv[++i];
+    else if (arg == "load" && i + 1 < argc)
+      load_path = argv[++i];
+  }
+
+  if (dense) {
+    AOC_ALLOC_PHASE("read");
+    Polygon polygon = Polygon::parse(aoc::io::read_lines());
+    AOC_ALLOC_PHASE("index");
+    PolygonIndex grid;
+    try {
+      grid = PolygonIndex(polygon);
+    } catch (const std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+    AOC_ALLOC_PHASE("part1");
+    part1(polygon.points);
+    AOC_ALLOC_PHASE("part2");
+    part2(polygon.points, grid, parallel);
+    return 0;
+  }
+
+  // Views into the store's mapping on a hit, into polygon otherwise
+  Polygon polygon;
+  std::span<const Point> points;
+  AreaIndex index;
+  auto store = load_path.empty()
+                   ? aoc::cache::Store::open(INDEX_TAG)
+                   : aoc::cache::Store::open_file(load_path, INDEX_TAG);
+  if (store.hit()) {
+    get_index(store, points, index);
+  } else if (!load_path.empty()) {
+    std::cerr << "Invalid index file: " << load_path << std::endl;
+    return 1;
+  } else {
+    AOC_ALLOC_PHASE("read");
+    auto lines = aoc::io::read_lines();
+    AOC_ALLOC_PHASE("parse");
+    polygon = Polygon::parse(lines);
+    AOC_ALLOC_PHASE("index");
+    points = polygon.points;
+    index = AreaIndex(points);
+    put_index(store, points, index);
+    store.save();
+  }
+
+  if (!save_path.empty()) {
+    auto out = aoc::cache::Store::open_file(save_path, INDEX_TAG);
+    put_index(out, points, index);
+    out.save();
+  }
 
-  // part1(lines);
-  part2(lines);
+  AOC_ALLOC_PHASE("part1");
+  part1(points);
+  AOC_ALLOC_PHASE("part2");
+  part2(points, index, parallel);
 
   return 0;
 }
+#endif
 
 /** Notes
  * The goal is to find the largest possible rectangle that can be formed using
@@ -172,4 +838,70 @@ int main() {
  *
  * TC: O(n^2) -> we need to traverse the grid
  * SC: O(n^2) -> we need to store the prefix sum for each point
+ *
+ * The grid above is as large as the coordinates: with values around 100k it
+ * takes tens of GB. Only the coordinates of the red tiles matter though, so we
+ * compress them: each distinct x (and y) becomes a cell of width 1, each gap
+ * between two of them a single cell as wide as the gap. The fill works the
+ * same on the compressed grid, and the prefix sum just weights each cell by
+ * its real area (width * height), so "sum == area" still holds.
+ *
+ * SC: O(n^2) -> n red tiles, whatever the coordinates
+ *
+ * The BFS flood fill is the slow part: every cell gets pushed up to 4 times.
+ * The polygon is rectilinear, so a ray cast works row by row instead: going
+ * left to right, we're inside after crossing an odd number of vertical edges.
+ * The edges crossing each row come from a toggle grid (flip at the top row of
+ * the edge, flip back at the bottom one) XOR-ed down the rows, so the whole
+ * classification is one streaming pass over a flat row-major grid.
+ *
+ * TC: O(W * H) -> compressed grid size, no queue
+ *
+ * Testing all the O(n^2) pairs is now the bottleneck.
+ * For part 1, if q is above and right of p, moving p down/left or q up/right
+ * only makes the rectangle bigger. So p can be taken from the bottom-left
+ * "staircase" (points nothing beats towards that corner) and q from the
+ * top-right one; mirroring y covers the other diagonal. Both staircases are
+ * sorted by x, and the best q for p only moves right as p does, so divide and
+ * conquer finds all of them in O(n log n).
+ *
+ * For part 2 validity breaks that structure, so it's branch and bound: the
+ * rectangle from p to the far corner of the bounding box bounds every pair
+ * using p. Visit p in decreasing order of bound, stop once the bound can't
+ * beat the best valid area, and for each p only scan the partners far enough
+ * in x (from both ends of the x order).
+ * On a circle that bound is useless: almost every p can reach far corners, so
+ * it's still n^2 pairs. A tighter one: the rectangle's side along p's row has
+ * to stay on the polygon, so its width is at most how far the row runs from p
+ * (same for the height and p's column). Those "reaches" come from one sweep
+ * per axis, and now each p gets a bound per quadrant, partners have to be
+ * within reach (both ways) and the 100k-point circle goes from 33s to 0.4s.
+ *
+ * TC: O(n log n) for part 1, O(n^2) worst case for part 2 but usually far less
+ * (a comb with 100k points, where every tooth reaches the whole base, still
+ * takes ~40s)
+ *
+ * Alternatively, the exhaustive part 2 loop is embarrassingly parallel: every
+ * check is an O(1) prefix sum lookup. Threads take balanced blocks of rows of
+ * the pair triangle and share the best area in an atomic, so most pairs are
+ * rejected with a multiplication and a relaxed load.
+ *
+ * TC: O(n^2 / threads)
+ *
+ * Both parts work on the same points, so they're parsed once into a Polygon,
+ * and everything part 2 needs (compressed axes, inside mask, prefix sums) is
+ * built once into a PolygonIndex. The index can be saved to a binary file and
+ * loaded back, so repeated queries on the same polygon skip parsing and
+ * rasterisation (same format as the shared input cache).
+ *
+ * The compressed grid is still (2n)^2 cells: past ~25k points it doesn't fit
+ * in memory. But the check only needs the tiles' area inside a rectangle, and
+ * the tiles are the polygon grown by half a tile, whose outline has the same
+ * n edges. The area left of X and below Y is a sum over the vertical outline
+ * edges left of X, and a persistent segment tree (one version per edge, in x
+ * order) answers it for any X and Y. Four of those per rectangle, like the
+ * prefix sums.
+ *
+ * TC: O(n log n) to build, O(log n) per check
+ * SC: O(n log n) -> ~90MB for 100k points, 1GB for 1M
  */
@@ -0,0 +1,139 @@
+#include "alloc.hpp"
+
+// Without AOC_ALLOC nothing in here is compiled: the global operator new and
+// delete stay the standard library's.
+#ifdef AOC_ALLOC
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace aoc::alloc {
+
+namespace {
+
+// Fixed table: registering a phase must not allocate
+constexpr int MAX_PHASES = 32;
+
+struct Phase {
+  std::atomic<const char *> name{nullptr};
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> peak{0};
+};
+
+Phase phases[MAX_PHASES]; // 0 is "startup"
+std::atomic<int> phase_count{1};
+std::atomic<int> current{0};
+std::atomic<uint64_t> live{0};
+
+void raise_peak(Phase &p, uint64_t value) {
+  uint64_t peak = p.peak.load(std::memory_order_relaxed);
+  while (value > peak &&
+         !p.peak.compare_exchange_weak(peak, value, std::memory_order_relaxed))
+    ;
+}
+
+void report() {
+  std::fprintf(stderr, "\n%-12s %12s %14s %14s\n", "phase", "allocs", "bytes",
+               "peak live");
+  for (int i = 0; i < phase_count.load(); ++i) {
+    const Phase &p = phases[i];
+    const char *name = i == 0 ? "startup" : p.name.load();
+    std::fprintf(stderr, "%-12s %12llu %14llu %14llu\n", name,
+                 (unsigned long long)p.count.load(),
+                 (unsigned long long)p.bytes.load(),
+                 (unsigned long long)p.peak.load());
+  }
+}
+
+// Every block is preceded by a 16-byte header: the distance back to the start
+// of the underlying malloc block, and the requested size. That's what lets
+// delete know how many live bytes it frees, sized or not.
+constexpr size_t HEADER = 16;
+
+void *allocate(size_t size, size_t align) {
+  size_t offset = align > HEADER ? align : HEADER;
+  void *raw = align > HEADER
+                  ? std::aligned_alloc(align, (size + offset + align - 1) /
+                                                  align * align)
+                  : std::malloc(size + offset);
+  if (!raw)
+    return nullptr;
+  char *user = static_cast<char *>(raw) + offset;
+  size_t header[2] = {offset, size};
+  std::memcpy(user - HEADER, header, sizeof(header));
+
+  Phase &p = phases[current.load(std::memory_order_relaxed)];
+  p.count.fetch_add(1, std::memory_order_relaxed);
+  p.bytes.fetch_add(size, std::memory_order_relaxed);
+  raise_peak(p, live.fetch_add(size, std::memory_order_relaxed) + size);
+  return user;
+}
+
+void deallocate(void *ptr) {
+  if (!ptr)
+    return;
+  char *user = static_cast<char *>(ptr);
+  size_t header[2];
+  std::memcpy(header, user - HEADER, sizeof(header));
+  live.fetch_sub(header[1], std::memory_order_relaxed);
+  std::free(user - header[0]);
+}
+
+} // namespace
+
+void phase(const char *name) {
+  int n = phase_count.load();
+  int index = -1;
+  for (int i = 1; i < n; ++i)
+    if (std::strcmp(phases[i].name.load(), name) == 0)
+      index = i;
+  if (index < 0) {
+    if (n == MAX_PHASES)
+      return; // keep charging the current phase
+    if (n == 1)
+      std::atexit(report);
+    index = n;
+    phases[index].name.store(name);
+    phase_count.store(n + 1);
+  }
+  raise_peak(phases[index], live.load());
+  current.store(index);
+}
+
+} // namespace aoc::alloc
+
+// The other forms (arrays, nothrow) forward to these in libstdc++, so
+// replacing them is enough to see every allocation.
+void *operator new(size_t size) {
+  if (void *p = aoc::alloc::allocate(size, 0))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new(size_t size, std::align_val_t align) {
+  if (void *p = aoc::alloc::allocate(size, size_t(align)))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { aoc::alloc::deallocate(ptr); }
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+  aoc::alloc::deallocate(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+  aoc::alloc::deallocate(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+  aoc::alloc::deallocate(ptr);
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+namespace aoc::alloc {
+
+/**
+ * @brief Starts a new allocation phase: every heap allocation from now on, on
+ * any thread, is charged to it until the next phase starts.
+ *
+ * With AOC_ALLOC (make ALLOC=1), global operator new and delete are replaced
+ * to keep, per phase, the number of allocations, the bytes requested and the
+ * peak of live heap bytes, and a report is printed to stderr at exit.
+ * Allocations before the first phase are reported as "startup".
+ *
+ * Use it through AOC_ALLOC_PHASE(name), which compiles to nothing without
+ * AOC_ALLOC. name must be a string literal. Phases are process-wide, so they
+ * only mean something in the single-day binaries, not in aoc_runner.
+ */
+void phase(const char *name);
+
+} // namespace aoc::alloc
+
+#ifdef AOC_ALLOC
+#define AOC_ALLOC_PHASE(name) aoc::alloc::phase(name)
+#else
+#define AOC_ALLOC_PHASE(name) ((void)0)
+#endif
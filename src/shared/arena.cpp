@@ -0,0 +1,41 @@
+#include "arena.hpp"
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace aoc {
+
+namespace {
+
+constexpr size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+size_t page_size() {
+  static const size_t size = sysconf(_SC_PAGESIZE);
+  return size;
+}
+
+size_t round_up(size_t n, size_t to) { return (n + to - 1) / to * to; }
+
+} // namespace
+
+void *PageResource::do_allocate(size_t bytes, size_t align) {
+  // mmap returns page-aligned memory, which covers any sane alignment
+  if (align > page_size())
+    throw std::bad_alloc();
+  size_t size = round_up(bytes, page_size());
+  void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+  if (size >= HUGE_PAGE)
+    madvise(p, size, MADV_HUGEPAGE); // best effort: THP may be disabled
+#endif
+  return p;
+}
+
+void PageResource::do_deallocate(void *p, size_t bytes, size_t) {
+  munmap(p, round_up(bytes, page_size()));
+}
+
+} // namespace aoc
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace aoc {
+
+/**
+ * @brief Upstream resource that takes memory straight from the kernel with
+ * mmap. Regions of 2 MiB or more are advised for transparent huge pages, so
+ * big tables (edge lists, grids) cost fewer TLB misses.
+ */
+class PageResource : public std::pmr::memory_resource {
+private:
+  void *do_allocate(size_t bytes, size_t align) override;
+  void do_deallocate(void *p, size_t bytes, size_t align) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+};
+
+/**
+ * @brief Bump allocator for parse-heavy solvers.
+ *
+ * A std::pmr::monotonic_buffer_resource on top of PageResource: allocating is
+ * a pointer bump, deallocating does nothing, and everything is handed back at
+ * once when the arena is released or destroyed. Use it with the std::pmr
+ * containers:
+ *   aoc::Arena arena;
+ *   std::pmr::vector<std::pmr::string> tokens(arena);
+ *
+ * Memory freed by a container (e.g. when a vector grows) is only reclaimed
+ * with the whole arena, so reserve when the final size is known.
+ * Arena memory doesn't go through operator new, so it doesn't show up in the
+ * ALLOC=1 report.
+ */
+class Arena {
+public:
+  explicit Arena(size_t initial_size = 64 * 1024)
+      : buffer(initial_size, &pages) {}
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  std::pmr::memory_resource *resource() { return &buffer; }
+  operator std::pmr::memory_resource *() { return &buffer; }
+  // So pmr containers can take the arena itself as their allocator
+  template <typename T> operator std::pmr::polymorphic_allocator<T>() {
+    return &buffer;
+  }
+
+  /**
+   * @brief Frees everything allocated from the arena at once.
+   * Containers still using it must not be touched afterwards.
+   */
+  void release() { buffer.release(); }
+
+private:
+  PageResource pages; // must outlive buffer
+  std::pmr::monotonic_buffer_resource buffer;
+};
+
+} // namespace aoc
@@ -0,0 +1,221 @@
+#include "cache.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace aoc::cache {
+
+namespace {
+
+constexpr char MAGIC[8] = {'A', 'O', 'C', 'C', 'A', 'C', 'H', 'E'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t TAG_SIZE = 48;
+constexpr size_t ALIGN = 64; // sections start on a cache line
+
+// File layout:
+//   Header
+//   SectionEntry[sections]
+//   payload, every section aligned to ALIGN
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t sections;
+  uint64_t source_size;
+  int64_t source_mtime; // ns since epoch
+  uint64_t checksum;    // of the payload
+  char tag[TAG_SIZE];
+};
+
+struct SectionEntry {
+  uint64_t offset; // from the start of the file
+  uint64_t bytes;
+};
+
+size_t align_up(size_t n) { return (n + ALIGN - 1) / ALIGN * ALIGN; }
+
+// FNV-1a, 8 bytes at a time: it only needs to catch truncated or corrupted
+// files, not adversarial ones.
+uint64_t checksum(const std::byte *data, size_t size) {
+  uint64_t h = 14695981039346656037ULL;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data + i, 8);
+    h = (h ^ word) * 1099511628211ULL;
+  }
+  for (; i < size; ++i)
+    h = (h ^ uint64_t(data[i])) * 1099511628211ULL;
+  return h;
+}
+
+void fill_tag(char (&dst)[TAG_SIZE], std::string_view tag) {
+  std::memset(dst, 0, TAG_SIZE);
+  std::memcpy(dst, tag.data(), std::min(tag.size(), TAG_SIZE - 1));
+}
+
+bool enabled() {
+  const char *env = std::getenv("AOC_CACHE");
+  return env && *env && std::string_view(env) != "0";
+}
+
+} // namespace
+
+Mapping &Mapping::operator=(Mapping &&other) noexcept {
+  if (this != &other) {
+    if (data)
+      munmap(const_cast<std::byte *>(data), size);
+    data = std::exchange(other.data, nullptr);
+    size = std::exchange(other.size, 0);
+  }
+  return *this;
+}
+
+Mapping::~Mapping() {
+  if (data)
+    munmap(const_cast<std::byte *>(data), size);
+}
+
+Mapping Mapping::open(const std::string &path, std::string_view tag,
+                      uint64_t source_size, int64_t source_mtime) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return {};
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+    close(fd);
+    return {};
+  }
+  void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    return {};
+
+  Mapping m;
+  m.data = static_cast<const std::byte *>(addr);
+  m.size = st.st_size;
+
+  Header h;
+  std::memcpy(&h, m.data, sizeof(h));
+  char expected_tag[TAG_SIZE];
+  fill_tag(expected_tag, tag);
+  size_t table_end = sizeof(Header) + size_t(h.sections) * sizeof(SectionEntry);
+  if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      h.version != VERSION ||
+      std::memcmp(h.tag, expected_tag, TAG_SIZE) != 0 ||
+      h.source_size != source_size || h.source_mtime != source_mtime ||
+      table_end > m.size)
+    return {};
+
+  for (size_t i = 0; i < m.sections(); ++i) {
+    SectionEntry e;
+    std::memcpy(&e, m.data + sizeof(Header) + i * sizeof(SectionEntry),
+                sizeof(e));
+    if (e.offset < table_end || e.offset > m.size ||
+        e.bytes > m.size - e.offset)
+      return {};
+  }
+
+  size_t payload = align_up(table_end);
+  if (payload > m.size ||
+      checksum(m.data + payload, m.size - payload) != h.checksum)
+    return {};
+  return m;
+}
+
+size_t Mapping::sections() const {
+  Header h;
+  std::memcpy(&h, data, sizeof(h));
+  return h.sections;
+}
+
+std::span<const std::byte> Mapping::section(size_t i) const {
+  if (i >= sections())
+    throw std::out_of_range("cache: no section " + std::to_string(i));
+  SectionEntry e;
+  std::memcpy(&e, data + sizeof(Header) + i * sizeof(SectionEntry), sizeof(e));
+  return {data + e.offset, e.bytes};
+}
+
+Store Store::open(std::string_view tag) {
+  Store store;
+  store.tag = tag;
+  if (!enabled())
+    return store;
+
+  // Only a regular file on stdin has a stable identity we can check against
+  struct stat st;
+  if (fstat(STDIN_FILENO, &st) != 0 || !S_ISREG(st.st_mode))
+    return store;
+  char buf[4096];
+  ssize_t len = readlink("/proc/self/fd/0", buf, sizeof(buf) - 1);
+  if (len <= 0)
+    return store;
+
+  store.path = std::string(buf, len) + ".cache";
+  store.source_size = st.st_size;
+  store.source_mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 +
+                       st.st_mtim.tv_nsec;
+  store.mapping = Mapping::open(store.path, store.tag, store.source_size,
+                                store.source_mtime);
+  return store;
+}
+
+Store Store::open_file(std::string path, std::string_view tag) {
+  Store store;
+  store.path = std::move(path);
+  store.tag = tag;
+  store.mapping = Mapping::open(store.path, store.tag, 0, 0);
+  return store;
+}
+
+bool Store::save() const {
+  if (path.empty())
+    return true;
+
+  Header h;
+  std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+  h.version = VERSION;
+  h.sections = parts.size();
+  h.source_size = source_size;
+  h.source_mtime = source_mtime;
+  fill_tag(h.tag, tag);
+
+  size_t table_end = sizeof(Header) + parts.size() * sizeof(SectionEntry);
+  std::vector<SectionEntry> table;
+  size_t offset = align_up(table_end);
+  for (const auto &part : parts) {
+    table.push_back({offset, part.size()});
+    offset = align_up(offset + part.size());
+  }
+
+  std::vector<std::byte> file(offset);
+  for (size_t i = 0; i < parts.size(); ++i)
+    std::copy(parts[i].begin(), parts[i].end(),
+              file.begin() + table[i].offset);
+  size_t payload = align_up(table_end);
+  h.checksum = checksum(file.data() + payload, file.size() - payload);
+  std::memcpy(file.data(), &h, sizeof(h));
+  std::memcpy(file.data() + sizeof(Header), table.data(),
+              table.size() * sizeof(SectionEntry));
+
+  // Write to a temporary file and rename it, so a concurrent reader never
+  // sees a half-written cache
+  std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(file.data()), file.size());
+    if (!out)
+      return false;
+  }
+  return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+} // namespace aoc::cache
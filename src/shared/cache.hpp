@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace aoc::cache {
+
+/**
+ * @brief A read-only memory mapping of a cache file.
+ * Sections are exposed as spans pointing straight into the mapping.
+ */
+class Mapping {
+public:
+  Mapping() = default;
+  Mapping(Mapping &&other) noexcept { *this = std::move(other); }
+  Mapping &operator=(Mapping &&other) noexcept;
+  Mapping(const Mapping &) = delete;
+  Mapping &operator=(const Mapping &) = delete;
+  ~Mapping();
+
+  /**
+   * @brief Maps the file at path and validates it: magic, format version,
+   * tag, source stamp (size and mtime of the input it was built from) and
+   * payload checksum. Returns an empty mapping if anything doesn't match.
+   */
+  static Mapping open(const std::string &path, std::string_view tag,
+                      uint64_t source_size, int64_t source_mtime);
+
+  explicit operator bool() const { return data != nullptr; }
+
+  size_t sections() const;
+  /**
+   * @brief Bytes of section i, std::out_of_range past the last one.
+   */
+  std::span<const std::byte> section(size_t i) const;
+
+private:
+  const std::byte *data = nullptr;
+  size_t size = 0;
+};
+
+/**
+ * @brief Parsed input backed either by a cache file or by the caller's own
+ * buffers.
+ *
+ * Usage:
+ *   auto store = aoc::cache::Store::open("day_02 ranges v1");
+ *   std::vector<Range> ranges;
+ *   if (!store.hit()) {
+ *     ranges = parse(aoc::io::read_lines());
+ *     store.put<Range>(ranges);
+ *     store.save();
+ *   }
+ *   solve(store.get<Range>(0));
+ *
+ * The cache is opt-in: it's only used when AOC_CACHE is set and stdin is a
+ * regular file. The file lives next to the input (<input>.cache) and is
+ * rebuilt whenever the input's size or mtime change, or the tag does (bump
+ * the version in the tag whenever the layout of a day's types changes).
+ * Data is stored raw, so the file is only valid for the machine and build
+ * that wrote it.
+ */
+class Store {
+public:
+  /**
+   * @brief Cache for the input on stdin (disabled unless AOC_CACHE is set).
+   */
+  static Store open(std::string_view tag);
+
+  /**
+   * @brief Cache at an explicit path, not tied to any input file.
+   */
+  static Store open_file(std::string path, std::string_view tag);
+
+  bool hit() const { return bool(mapping); }
+
+  /**
+   * @brief Section i: from the mapping on a hit, from the i-th put otherwise.
+   * Throws std::out_of_range if there's no such section either way.
+   */
+  template <typename T> std::span<const T> get(size_t i) const {
+    static_assert(std::is_trivially_copyable_v<T>);
+    auto bytes = hit() ? mapping.section(i) : parts.at(i);
+    return {reinterpret_cast<const T *>(bytes.data()),
+            bytes.size() / sizeof(T)};
+  }
+
+  /**
+   * @brief Records the next section. The data must outlive the store.
+   */
+  template <typename T> void put(std::span<const T> data) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    parts.push_back(std::as_bytes(data));
+  }
+  template <typename T> void put(const std::vector<T> &data) {
+    put(std::span<const T>(data));
+  }
+
+  /**
+   * @brief Writes the recorded sections to the cache file, if enabled.
+   * Returns false if the file couldn't be written.
+   */
+  bool save() const;
+
+private:
+  std::string path; // empty when caching is disabled
+  std::string tag;
+  uint64_t source_size = 0;
+  int64_t source_mtime = 0;
+  Mapping mapping;
+  std::vector<std::span<const std::byte>> parts;
+};
+
+} // namespace aoc::cache
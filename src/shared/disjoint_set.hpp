@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace aoc {
+
+/**
+ * @brief Union-find with union by size and iterative path halving.
+ * Parents and sizes share one int array: a root stores minus the size of its
+ * set, any other node stores its parent. No recursion, so million-node chains
+ * are fine.
+ */
+class DisjointSet {
+public:
+  explicit DisjointSet(size_t n) : data(n, -1), sets(n) {}
+
+  int find(int x) {
+    while (data[x] >= 0) {
+      int p = data[x];
+      if (data[p] >= 0)
+        data[x] = data[p]; // path halving: skip to the grandparent
+      x = data[x];
+    }
+    return x;
+  }
+
+  /**
+   * @brief Merges the sets of a and b.
+   * Returns false if they were already in the same set.
+   */
+  bool unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b)
+      return false;
+    if (data[a] > data[b]) // sizes are negative: a is the smaller set
+      std::swap(a, b);
+    data[a] += data[b];
+    data[b] = a;
+    sets--;
+    return true;
+  }
+
+  bool same(int a, int b) { return find(a) == find(b); }
+
+  int size(int x) { return -data[find(x)]; }
+
+  bool is_root(int x) const { return data[x] < 0; }
+
+  size_t count() const { return sets; } // number of disjoint sets
+
+private:
+  std::vector<int> data;
+  size_t sets;
+};
+
+/**
+ * @brief Lock-free union-find for processing edges from several threads.
+ * Roots are linked with a CAS, always the larger index under the smaller one,
+ * so concurrent links can never form a cycle. Path halving is best effort: a
+ * failed CAS just means another thread already shortened the path.
+ * Sizes are not tracked; count them from the roots once the threads are done.
+ */
+class ConcurrentDisjointSet {
+public:
+  explicit ConcurrentDisjointSet(size_t n)
+      : parent(std::make_unique<std::atomic<int>[]>(n)) {
+    for (size_t i = 0; i < n; ++i)
+      parent[i].store(i, std::memory_order_relaxed);
+  }
+
+  int find(int x) {
+    while (true) {
+      int p = parent[x].load(std::memory_order_acquire);
+      if (p == x)
+        return x;
+      int gp = parent[p].load(std::memory_order_acquire);
+      if (p != gp)
+        parent[x].compare_exchange_weak(p, gp, std::memory_order_release,
+                                        std::memory_order_relaxed);
+      x = gp;
+    }
+  }
+
+  bool unite(int a, int b) {
+    while (true) {
+      a = find(a);
+      b = find(b);
+      if (a == b)
+        return false;
+      if (a > b)
+        std::swap(a, b);
+      // Only succeeds if b is still a root, otherwise retry from the top
+      int expected = b;
+      if (parent[b].compare_exchange_strong(expected, a,
+                                            std::memory_order_acq_rel))
+        return true;
+    }
+  }
+
+  bool same(int a, int b) {
+    while (true) {
+      a = find(a);
+      b = find(b);
+      if (a == b)
+        return true;
+      // a is still a root, so they really were in different sets
+      if (parent[a].load(std::memory_order_acquire) == a)
+        return false;
+    }
+  }
+
+private:
+  std::unique_ptr<std::atomic<int>[]> parent;
+};
+
+} // namespace aoc
@@ -1,8 +1,23 @@
 #include "io.hpp"
+#include <algorithm>
+#include <fcntl.h>
 #include <iterator>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace aoc::io {
 
+std::string to_string(u128 v) {
+  std::string s;
+  do {
+    s.push_back('0' + int(v % 10));
+    v /= 10;
+  } while (v);
+  std::reverse(s.begin(), s.end());
+  return s;
+}
+
 std::string read_all(std::istream &in) {
   // Optimization: Disable sync with stdio for speed
   std::ios::sync_with_stdio(false);
@@ -24,9 +39,87 @@ std::vector<std::string> read_lines(std::istream &in) {
   return lines;
 }
 
+Lines read_lines(std::pmr::memory_resource *mem, std::istream &in) {
+  Lines lines(mem);
+  std::pmr::string line(mem);
+
+  while (std::getline(in, line)) {
+    if (!line.empty())
+      lines.push_back(line); // copied into mem as well
+  }
+  return lines;
+}
+
 std::vector<std::string> read_grid(std::istream &in) {
   // In AoC, a grid is just a vector of strings where each string is a row.
   // Usually, padding is required, but we'll stick to raw reading here.
   return read_lines(in);
 }
+
+std::vector<std::string> split_lines(std::string_view text) {
+  std::vector<std::string> lines;
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    std::string_view line = text.substr(0, end);
+    if (!line.empty()) // same as read_lines
+      lines.emplace_back(line);
+    if (end == std::string_view::npos)
+      break;
+    text.remove_prefix(end + 1);
+  }
+  return lines;
+}
+
+Lines split_lines(std::string_view text, std::pmr::memory_resource *mem) {
+  Lines lines(mem);
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    std::string_view line = text.substr(0, end);
+    if (!line.empty())
+      lines.emplace_back(line);
+    if (end == std::string_view::npos)
+      break;
+    text.remove_prefix(end + 1);
+  }
+  return lines;
+}
+
+namespace {
+thread_local std::ostream *current_out = nullptr;
+}
+
+std::ostream &out() { return current_out ? *current_out : std::cout; }
+
+OutputRedirect::OutputRedirect(std::ostream &target) : previous(current_out) {
+  current_out = &target;
+}
+
+OutputRedirect::~OutputRedirect() { current_out = previous; }
+
+MappedFile::MappedFile(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (fstat(fd, &st) == 0) {
+    size = st.st_size;
+    ok = true;
+    if (size > 0) {
+      void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        size = 0;
+        ok = false;
+      } else {
+        data = static_cast<const char *>(addr);
+        madvise(addr, size, MADV_SEQUENTIAL);
+      }
+    }
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data)
+    munmap(const_cast<char *>(data), size);
+}
 } // namespace aoc::io
@@ -1,11 +1,28 @@
 #pragma once
 
+#include <cstddef>
 #include <iostream>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
+namespace aoc {
+
+/**
+ * @brief Unsigned 128-bit integer, for answers that outgrow 64 bits.
+ */
+__extension__ typedef unsigned __int128 u128;
+
+} // namespace aoc
+
 namespace aoc::io {
 
+/**
+ * @brief Decimal digits of v: std::to_string has no 128-bit overload.
+ */
+std::string to_string(u128 v);
+
 /**
  * @brief Reads the entire standard input into a single string.
  * Useful when the input is a single block or complex parsing is needed.
@@ -18,10 +35,69 @@ std::string read_all(std::istream &in = std::cin);
  */
 std::vector<std::string> read_lines(std::istream &in = std::cin);
 
+/**
+ * @brief Input lines allocated from a memory resource, typically an
+ * aoc::Arena.
+ */
+using Lines = std::pmr::vector<std::pmr::string>;
+
+/**
+ * @brief Same as read_lines, with every line allocated from mem.
+ */
+Lines read_lines(std::pmr::memory_resource *mem, std::istream &in = std::cin);
+
 /**
  * @brief Reads standard input as a grid of characters.
  * Essential for maze/map problems.
  */
 std::vector<std::string> read_grid(std::istream &in = std::cin);
 
+/**
+ * @brief Splits an in-memory input into lines, skipping empty ones like
+ * read_lines does.
+ */
+std::vector<std::string> split_lines(std::string_view text);
+Lines split_lines(std::string_view text, std::pmr::memory_resource *mem);
+
+/**
+ * @brief Where solvers print their answers: std::cout, unless redirected on
+ * the calling thread.
+ */
+std::ostream &out();
+
+/**
+ * @brief Redirects out() on the current thread while the object lives.
+ * Lets several days run concurrently without mixing their answers.
+ */
+class OutputRedirect {
+public:
+  explicit OutputRedirect(std::ostream &target);
+  ~OutputRedirect();
+  OutputRedirect(const OutputRedirect &) = delete;
+  OutputRedirect &operator=(const OutputRedirect &) = delete;
+
+private:
+  std::ostream *previous;
+};
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ * Check with operator bool: false if the file couldn't be opened.
+ */
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  explicit operator bool() const { return ok; }
+  std::string_view view() const { return {data, size}; }
+
+private:
+  const char *data = nullptr;
+  size_t size = 0;
+  bool ok = false;
+};
+
 } // namespace aoc::io
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace aoc {
+
+/**
+ * @brief Number of worker threads to use (at least 1).
+ * Inside a thread pool, that's the size of the pool.
+ */
+inline int thread_count() {
+  if (ThreadPool *pool = ThreadPool::current())
+    return pool->size();
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Runs f(0) .. f(threads - 1) in parallel and waits for all of them.
+ * f(0) runs on the calling thread. When called from a pool worker, the rest
+ * are queued on that pool instead of spawning threads.
+ */
+template <typename F> void run_threads(int threads, F f) {
+  if (ThreadPool *shared = ThreadPool::current()) {
+    TaskGroup group(*shared);
+    for (int t = 1; t < threads; ++t)
+      group.run([&f, t] { f(t); });
+    f(0);
+    group.wait();
+    return;
+  }
+  std::vector<std::thread> pool;
+  for (int t = 1; t < threads; ++t)
+    pool.emplace_back(f, t);
+  f(0);
+  for (auto &th : pool)
+    th.join();
+}
+
+} // namespace aoc
@@ -0,0 +1,187 @@
+#include "perf.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <linux/perf_event.h>
+#include <mutex>
+#include <string_view>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+namespace aoc::perf {
+
+namespace {
+
+constexpr uint64_t EVENT_CONFIG[Scope::EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+// One counter group per thread, opened on first use. Events the CPU (or VM)
+// doesn't support are left out of the group and reported as n/a.
+struct Counters {
+  int leader = -1;
+  int fds[Scope::EVENTS];
+  int slot[Scope::EVENTS]; // position in the group read, or -1
+  int members = 0;
+  int error = 0;
+
+  Counters() {
+    std::fill(std::begin(fds), std::end(fds), -1);
+    std::fill(std::begin(slot), std::end(slot), -1);
+    for (int e = 0; e < Scope::EVENTS; ++e) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = EVENT_CONFIG[e];
+      attr.exclude_kernel = 1; // allowed with perf_event_paranoid <= 2
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      int fd = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+      if (fd < 0) {
+        if (e == 0) { // no cycles counter: give up on the whole group
+          error = errno;
+          return;
+        }
+        continue;
+      }
+      if (leader < 0)
+        leader = fd;
+      fds[e] = fd;
+      slot[e] = members++;
+    }
+  }
+
+  ~Counters() {
+    for (int fd : fds)
+      if (fd >= 0)
+        close(fd);
+  }
+
+  // Current values, scaled up if the kernel had to multiplex the group
+  bool read(uint64_t (&values)[Scope::EVENTS]) const {
+    if (leader < 0)
+      return false;
+    uint64_t buf[3 + Scope::EVENTS]; // nr, time enabled, time running, values
+    if (::read(leader, buf, sizeof(buf)) < ssize_t(3 * sizeof(uint64_t)))
+      return false;
+    double scale = buf[2] ? double(buf[1]) / buf[2] : 1.0;
+    for (int e = 0; e < Scope::EVENTS; ++e)
+      values[e] = slot[e] < 0 ? 0 : uint64_t(buf[3 + slot[e]] * scale);
+    return true;
+  }
+};
+
+Counters &thread_counters() {
+  thread_local Counters counters;
+  return counters;
+}
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Region {
+  const char *name;
+  uint64_t calls = 0;
+  uint64_t elements = 0;
+  uint64_t counts[Scope::EVENTS] = {};
+  int64_t ns = 0;
+  bool missing[Scope::EVENTS] = {};
+  bool counted = false; // at least one call had working counters
+};
+
+std::mutex regions_mutex;
+std::vector<Region> regions; // in order of first use
+int counters_error = 0;
+
+void print_per_element(uint64_t count, uint64_t elements, bool missing) {
+  if (missing || elements == 0)
+    std::fprintf(stderr, " %12s", "n/a");
+  else
+    std::fprintf(stderr, " %12.4f", double(count) / elements);
+}
+
+void report() {
+  std::lock_guard lock(regions_mutex);
+  if (regions.empty())
+    return;
+  std::fprintf(stderr, "\n%-28s %6s %12s %10s %6s %12s %12s %12s\n", "region",
+               "calls", "elements", "ms", "IPC", "cycles/elem",
+               "cmiss/elem", "bmiss/elem");
+  for (const auto &r : regions) {
+    std::fprintf(stderr, "%-28s %6llu %12llu %10.3f", r.name,
+                 (unsigned long long)r.calls, (unsigned long long)r.elements,
+                 r.ns / 1e6);
+    if (!r.counted) {
+      std::fprintf(stderr, " %6s\n", "-");
+      continue;
+    }
+    if (r.counts[0] && !r.missing[1])
+      std::fprintf(stderr, " %6.2f", double(r.counts[1]) / r.counts[0]);
+    else
+      std::fprintf(stderr, " %6s", "n/a");
+    print_per_element(r.counts[0], r.elements, false);
+    print_per_element(r.counts[2], r.elements, r.missing[2]);
+    print_per_element(r.counts[3], r.elements, r.missing[3]);
+    std::fprintf(stderr, "\n");
+  }
+  if (counters_error)
+    std::fprintf(stderr, "perf: hardware counters unavailable (%s), "
+                 "check /proc/sys/kernel/perf_event_paranoid\n",
+                 std::strerror(counters_error));
+}
+
+Region &region(const char *name) {
+  // Names are literals, but the same literal isn't guaranteed to have a single
+  // address across translation units: compare the text
+  for (auto &r : regions)
+    if (std::string_view(r.name) == name)
+      return r;
+  if (regions.empty())
+    std::atexit(report);
+  regions.push_back({name});
+  return regions.back();
+}
+
+} // namespace
+
+Scope::Scope(const char *name, uint64_t elements)
+    : name(name), elements(elements) {
+  counting = thread_counters().read(start);
+  start_ns = now_ns();
+}
+
+Scope::~Scope() {
+  int64_t ns = now_ns() - start_ns;
+  uint64_t end[EVENTS];
+  const Counters &counters = thread_counters();
+  bool counted = counting && counters.read(end);
+
+  std::lock_guard lock(regions_mutex);
+  Region &r = region(name);
+  r.calls++;
+  r.elements += elements;
+  r.ns += ns;
+  if (counted) {
+    r.counted = true;
+    for (int e = 0; e < EVENTS; ++e) {
+      // Scaled values of a multiplexed group can step back slightly
+      r.counts[e] += end[e] > start[e] ? end[e] - start[e] : 0;
+      r.missing[e] = counters.slot[e] < 0;
+    }
+  } else if (counters.error) {
+    counters_error = counters.error;
+  }
+}
+
+} // namespace aoc::perf
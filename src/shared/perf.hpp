@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aoc::perf {
+
+/**
+ * @brief Hardware counters around a named region of code.
+ *
+ * Counts cycles, instructions, cache misses and branch misses of the calling
+ * thread (work handed to other threads isn't included) with perf_event_open,
+ * and adds them to the region's totals. The totals are printed to stderr at
+ * exit, with IPC and counts per element, elements being whatever unit the
+ * region loops over (cells, edges, ...).
+ *
+ * Don't use it directly: AOC_PERF_SCOPE(name, elements) expands to a Scope
+ * only when built with AOC_PERF (make PERF=1), and to nothing otherwise, so
+ * neither the counters nor the element count cost anything in normal builds.
+ * name must be a string literal.
+ */
+class Scope {
+public:
+  Scope(const char *name, uint64_t elements);
+  ~Scope();
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+  static constexpr int EVENTS = 4; // cycles, instructions, cache/branch misses
+
+private:
+  const char *name;
+  uint64_t elements;
+  uint64_t start[EVENTS];
+  int64_t start_ns;
+  bool counting;
+};
+
+/**
+ * @brief Total size of a range of containers, e.g. the characters of an input
+ * given as lines. A common element count for regions.
+ */
+template <typename Range> uint64_t total_size(const Range &range) {
+  uint64_t n = 0;
+  for (const auto &item : range)
+    n += item.size();
+  return n;
+}
+
+} // namespace aoc::perf
+
+#ifdef AOC_PERF
+#define AOC_PERF_CONCAT_(a, b) a##b
+#define AOC_PERF_CONCAT(a, b) AOC_PERF_CONCAT_(a, b)
+#define AOC_PERF_SCOPE(name, elements)                                         \
+  aoc::perf::Scope AOC_PERF_CONCAT(aoc_perf_scope_, __LINE__)(name, elements)
+#else
+#define AOC_PERF_SCOPE(name, elements) ((void)0)
+#endif
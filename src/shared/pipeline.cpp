@@ -0,0 +1,293 @@
+#include "pipeline.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cerrno>
+#include <deque>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+namespace aoc::io {
+
+// Just enough io_uring for reads, straight on the syscalls like perf.cpp
+// does for perf_event_open, so there's no liburing dependency.
+struct ChunkReader::Ring {
+  int fd = -1;
+  void *sq = MAP_FAILED, *cq = MAP_FAILED, *sqe_map = MAP_FAILED;
+  size_t sq_len = 0, cq_len = 0, sqe_len = 0;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  io_uring_sqe *sqes;
+  io_uring_cqe *cqes;
+  unsigned queued = 0; // reads not submitted yet
+
+  // Null if the kernel doesn't have io_uring or doesn't let us use it
+  static std::unique_ptr<Ring> create(unsigned entries) {
+    io_uring_params p{};
+    auto ring = std::make_unique<Ring>();
+    ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0)
+      return nullptr;
+
+    ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single)
+      ring->sq_len = ring->cq_len = std::max(ring->sq_len, ring->cq_len);
+    ring->sq = mmap(nullptr, ring->sq_len, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq == MAP_FAILED)
+      return nullptr;
+    ring->cq = single ? ring->sq
+                      : mmap(nullptr, ring->cq_len, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring->fd,
+                             IORING_OFF_CQ_RING);
+    ring->sqe_len = p.sq_entries * sizeof(io_uring_sqe);
+    ring->sqe_map = mmap(nullptr, ring->sqe_len, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->cq == MAP_FAILED || ring->sqe_map == MAP_FAILED)
+      return nullptr;
+
+    auto at = [](void *base, unsigned offset) {
+      return reinterpret_cast<unsigned *>(static_cast<char *>(base) + offset);
+    };
+    ring->sq_head = at(ring->sq, p.sq_off.head);
+    ring->sq_tail = at(ring->sq, p.sq_off.tail);
+    ring->sq_mask = at(ring->sq, p.sq_off.ring_mask);
+    ring->sq_array = at(ring->sq, p.sq_off.array);
+    ring->cq_head = at(ring->cq, p.cq_off.head);
+    ring->cq_tail = at(ring->cq, p.cq_off.tail);
+    ring->cq_mask = at(ring->cq, p.cq_off.ring_mask);
+    ring->sqes = static_cast<io_uring_sqe *>(ring->sqe_map);
+    ring->cqes = reinterpret_cast<io_uring_cqe *>(
+        static_cast<char *>(ring->cq) + p.cq_off.cqes);
+    return ring;
+  }
+
+  ~Ring() {
+    if (sqe_map != MAP_FAILED)
+      munmap(sqe_map, sqe_len);
+    if (cq != MAP_FAILED && cq != sq)
+      munmap(cq, cq_len);
+    if (sq != MAP_FAILED)
+      munmap(sq, sq_len);
+    if (fd >= 0)
+      close(fd);
+  }
+
+  // The caller never has more reads in flight than the ring has entries.
+  // Returns the read's position in the submission queue, see consumed().
+  unsigned read(int file, char *buf, size_t len, uint64_t offset,
+                uint64_t tag) {
+    unsigned tail = *sq_tail;
+    unsigned index = tail & *sq_mask;
+    io_uring_sqe &sqe = sqes[index];
+    sqe = {};
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = file;
+    sqe.addr = reinterpret_cast<uint64_t>(buf);
+    sqe.len = len;
+    sqe.off = offset;
+    sqe.user_data = tag;
+    sq_array[index] = index;
+    std::atomic_ref(*sq_tail).store(tail + 1, std::memory_order_release);
+    queued++;
+    return tail;
+  }
+
+  // Whether the kernel has taken the read at position pos off the submission
+  // queue: from then on it can complete into the buffer at any time
+  bool consumed(unsigned pos) const {
+    unsigned head = std::atomic_ref(*sq_head).load(std::memory_order_acquire);
+    return int(pos - head) < 0;
+  }
+
+  // Submits the queued reads (unless told not to) and waits until at least
+  // one has completed
+  bool wait(bool submit = true) {
+    while (true) {
+      long n = syscall(__NR_io_uring_enter, fd, submit ? queued : 0, 1,
+                       IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (n >= 0) {
+        queued -= std::min<unsigned>(n, queued);
+        return true;
+      }
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        return false;
+    }
+  }
+
+  // f(tag, result) for every completion available
+  template <typename F> void reap(F f) {
+    unsigned head = *cq_head;
+    unsigned tail = std::atomic_ref(*cq_tail).load(std::memory_order_acquire);
+    for (; head != tail; head++) {
+      const io_uring_cqe &cqe = cqes[head & *cq_mask];
+      f(cqe.user_data, cqe.res);
+    }
+    std::atomic_ref(*cq_head).store(head, std::memory_order_release);
+  }
+};
+
+ChunkReader::ChunkReader(int fd, size_t chunk_size, size_t chunks)
+    : fd(fd), chunk_size(chunk_size), filled(chunks + 1), spare(chunks) {
+  for (size_t i = 0; i < chunks; ++i) {
+    buffers.push_back(std::make_unique<char[]>(chunk_size));
+    spare.push(buffers.back().get());
+  }
+
+  // Only regular files have offsets to read ahead at
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    ring = Ring::create(std::bit_ceil(chunks));
+
+  reader = std::thread([this] {
+    if (ring)
+      read_uring();
+    else
+      read_blocking();
+    filled.push({}); // end of input
+  });
+}
+
+ChunkReader::~ChunkReader() {
+  while (!done)
+    next();
+  reader.join();
+}
+
+std::string_view ChunkReader::next() {
+  if (current)
+    spare.push(std::exchange(current, nullptr));
+  if (done)
+    return {};
+  Chunk chunk = filled.pop();
+  if (!chunk.data) {
+    done = true;
+    return {};
+  }
+  current = chunk.data;
+  return {chunk.data, chunk.size};
+}
+
+// One read() per chunk: on a pipe that hands over whatever the writer has
+// produced so far instead of waiting for a full buffer.
+void ChunkReader::read_blocking() {
+  while (true) {
+    char *buf = spare.pop();
+    ssize_t n;
+    do
+      n = ::read(fd, buf, chunk_size);
+    while (n < 0 && errno == EINTR);
+    if (n <= 0)
+      return;
+    filled.push({buf, size_t(n)});
+  }
+}
+
+// Keeps a read in flight for every spare buffer, at consecutive offsets, and
+// hands the chunks over in file order as they complete.
+void ChunkReader::read_uring() {
+  struct stat st;
+  fstat(fd, &st);
+  uint64_t offset = std::max<off_t>(lseek(fd, 0, SEEK_CUR), 0);
+  uint64_t end = st.st_size;
+
+  struct Read {
+    char *data;
+    uint64_t offset;
+    size_t want;
+    int result;
+    bool complete;
+    unsigned sqe; // position in the submission queue
+  };
+  std::vector<Read> reads(buffers.size());
+  std::vector<size_t> free_slots;
+  for (size_t s = reads.size(); s-- > 0;)
+    free_slots.push_back(s);
+  std::deque<size_t> order; // slots in flight, by offset
+  std::vector<char *> idle; // buffers that came back empty
+  bool broken = false;      // io_uring_enter failed, pread from now on
+
+  while (true) {
+    // Only block for a buffer when there's nothing else to wait for
+    while (offset < end && !free_slots.empty()) {
+      char *buf;
+      if (!idle.empty()) {
+        buf = idle.back();
+        idle.pop_back();
+      } else if (order.empty()) {
+        buf = spare.pop();
+      } else if (!spare.try_pop(buf)) {
+        break;
+      }
+      size_t s = free_slots.back();
+      free_slots.pop_back();
+      size_t want = std::min<uint64_t>(chunk_size, end - offset);
+      reads[s] = {buf, offset, want, -1, broken, 0};
+      if (!broken)
+        reads[s].sqe = ring->read(fd, buf, want, offset, s);
+      order.push_back(s);
+      offset += want;
+    }
+    if (order.empty())
+      break;
+
+    auto reap = [&] {
+      ring->reap([&](uint64_t s, int result) {
+        reads[s].result = result;
+        reads[s].complete = true;
+      });
+    };
+    if (!broken && ring->wait()) {
+      reap();
+    } else if (!broken) {
+      // Reads the kernel never took are left to pread: nothing submits them
+      // any more. The ones it took may still land in their buffers, so they
+      // have to complete before any buffer is handed over or reused. If
+      // io_uring_enter keeps failing, completions are still posted as task
+      // work on the way back from other syscalls, such as the sleep.
+      broken = true;
+      for (size_t s : order)
+        if (!reads[s].complete && !ring->consumed(reads[s].sqe))
+          reads[s].complete = true;
+      auto in_flight = [&] {
+        return std::any_of(order.begin(), order.end(),
+                           [&](size_t s) { return !reads[s].complete; });
+      };
+      while (in_flight()) {
+        if (!ring->wait(false))
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        reap();
+      }
+    }
+
+    while (!order.empty() && reads[order.front()].complete) {
+      Read &r = reads[order.front()];
+      // Failed reads (IORING_OP_READ needs Linux 5.6) and short ones are
+      // completed with plain preads
+      size_t got = std::max(r.result, 0);
+      while (got < r.want) {
+        ssize_t n = pread(fd, r.data + got, r.want - got, r.offset + got);
+        if (n < 0 && errno == EINTR)
+          continue;
+        if (n <= 0)
+          break;
+        got += n;
+      }
+      if (got < r.want)
+        end = offset; // the file shrank under us: stop at this chunk
+      if (got > 0)
+        filled.push({r.data, got});
+      else
+        idle.push_back(r.data);
+      free_slots.push_back(order.front());
+      order.pop_front();
+    }
+  }
+}
+
+} // namespace aoc::io
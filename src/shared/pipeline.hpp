@@ -0,0 +1,88 @@
+#pragma once
+
+#include "spsc_queue.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace aoc::io {
+
+/**
+ * @brief Reads a file descriptor in chunks on a separate thread, so parsing
+ * and solving the current chunk overlaps with reading the next ones.
+ * Regular files are read with io_uring, several chunks in flight at once,
+ * when the kernel allows it; anything else (pipes, terminals, old kernels)
+ * with plain blocking reads.
+ */
+class ChunkReader {
+public:
+  explicit ChunkReader(int fd = STDIN_FILENO, size_t chunk_size = 1 << 20,
+                       size_t chunks = 4);
+  ~ChunkReader(); // reads and drops whatever the consumer didn't take
+  ChunkReader(const ChunkReader &) = delete;
+  ChunkReader &operator=(const ChunkReader &) = delete;
+
+  /**
+   * @brief Next chunk of the input, empty at the end. Only valid until the
+   * next call, which hands its buffer back to the reader.
+   */
+  std::string_view next();
+
+  /**
+   * @brief Whether the reader thread is using io_uring.
+   */
+  bool uring() const { return ring != nullptr; }
+
+  struct Chunk {
+    char *data = nullptr;
+    size_t size = 0;
+  };
+
+private:
+  struct Ring; // minimal io_uring, see pipeline.cpp
+
+  void read_blocking();
+  void read_uring();
+
+  int fd;
+  size_t chunk_size;
+  std::vector<std::unique_ptr<char[]>> buffers;
+  SpscQueue<Chunk> filled; // reader -> consumer, in file order
+  SpscQueue<char *> spare; // consumer -> reader
+  char *current = nullptr; // buffer the consumer is holding
+  bool done = false;
+  std::unique_ptr<Ring> ring; // null for blocking reads
+  std::thread reader;
+};
+
+/**
+ * @brief Calls f(line) for every non-empty line of fd, like read_lines but
+ * without waiting for the whole input: lines are handed over as soon as
+ * their chunk has been read. The view is only valid during the call.
+ */
+template <typename F> void for_each_line(F &&f, int fd = STDIN_FILENO) {
+  ChunkReader reader(fd);
+  std::string carry; // a line split across two chunks
+  for (auto chunk = reader.next(); !chunk.empty(); chunk = reader.next()) {
+    for (size_t end; (end = chunk.find('\n')) != chunk.npos;) {
+      std::string_view line = chunk.substr(0, end);
+      if (!carry.empty()) {
+        carry.append(line);
+        line = carry;
+      }
+      if (!line.empty())
+        f(line);
+      carry.clear();
+      chunk.remove_prefix(end + 1);
+    }
+    carry.append(chunk);
+  }
+  if (!carry.empty())
+    f(std::string_view(carry));
+}
+
+} // namespace aoc::io
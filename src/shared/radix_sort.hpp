@@ -0,0 +1,67 @@
+#pragma once
+
+#include "parallel.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace aoc {
+
+/**
+ * @brief Stable LSD radix sort of items by key(item), an unsigned 64-bit
+ * value, one byte per pass.
+ * Each pass: every thread builds the histogram of its chunk, a prefix sum
+ * over (digit, thread) gives every thread its own write positions, then the
+ * threads scatter in parallel. Passes over bytes that are the same in every
+ * key are skipped.
+ */
+template <typename T, typename Key>
+void radix_sort(std::vector<T> &items, Key key, int threads) {
+  constexpr int RADIX = 256;
+  size_t n = items.size();
+  std::vector<T> tmp(n);
+  std::vector<std::array<size_t, RADIX>> hist(threads);
+
+  auto chunk = [&](int t) {
+    return std::pair<size_t, size_t>{n * t / threads, n * (t + 1) / threads};
+  };
+
+  uint64_t all_or = 0, all_and = ~uint64_t(0);
+  for (const T &item : items) {
+    all_or |= key(item);
+    all_and &= key(item);
+  }
+
+  for (int shift = 0; shift < 64; shift += 8) {
+    if ((((all_or ^ all_and) >> shift) & 0xff) == 0)
+      continue; // every key has the same byte here
+
+    run_threads(threads, [&](int t) {
+      auto [lo, hi] = chunk(t);
+      hist[t].fill(0);
+      for (size_t i = lo; i < hi; ++i)
+        hist[t][(key(items[i]) >> shift) & 0xff]++;
+    });
+
+    size_t sum = 0;
+    for (int d = 0; d < RADIX; ++d) {
+      for (int t = 0; t < threads; ++t) {
+        size_t count = hist[t][d];
+        hist[t][d] = sum;
+        sum += count;
+      }
+    }
+
+    run_threads(threads, [&](int t) {
+      auto [lo, hi] = chunk(t);
+      auto &pos = hist[t];
+      for (size_t i = lo; i < hi; ++i)
+        tmp[pos[(key(items[i]) >> shift) & 0xff]++] = items[i];
+    });
+    items.swap(tmp);
+  }
+}
+
+} // namespace aoc
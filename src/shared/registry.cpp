@@ -0,0 +1,21 @@
+#include "registry.hpp"
+
+namespace aoc {
+
+namespace {
+// Function-local static: days register during static initialisation, in no
+// particular order relative to this file
+std::map<int, Solver> &registry() {
+  static std::map<int, Solver> days;
+  return days;
+}
+} // namespace
+
+bool register_day(int day, Solver solve) {
+  registry()[day] = solve;
+  return true;
+}
+
+const std::map<int, Solver> &registered_days() { return registry(); }
+
+} // namespace aoc
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <map>
+#include <string_view>
+
+namespace aoc {
+
+/**
+ * @brief A day's entry point: solves both parts of the given input with the
+ * default engine and prints the answers to aoc::io::out().
+ */
+using Solver = void (*)(std::string_view input);
+
+/**
+ * @brief Registers a day for the multi-day runner.
+ * Returns true so it can initialise a namespace-scope constant:
+ *   [[maybe_unused]] const bool registered = aoc::register_day(7, solve);
+ */
+bool register_day(int day, Solver solve);
+
+/**
+ * @brief Every registered day, by number.
+ */
+const std::map<int, Solver> &registered_days();
+
+} // namespace aoc
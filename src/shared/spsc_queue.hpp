@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace aoc {
+
+/**
+ * @brief Bounded lock-free queue for exactly one producer and one consumer
+ * thread.
+ * The producer only writes tail and the consumer only writes head, each on
+ * its own cache line, so there is no CAS anywhere. The blocking push/pop
+ * sleep on the other side's index with atomic wait/notify instead of
+ * spinning, which matters when both threads share a core.
+ */
+template <typename T> class SpscQueue {
+public:
+  // Capacity is rounded up to a power of two
+  explicit SpscQueue(size_t capacity)
+      : slots(std::bit_ceil(std::max<size_t>(capacity, 1))),
+        mask(slots.size() - 1) {}
+
+  bool try_push(T value) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == slots.size())
+      return false;
+    publish(t, std::move(value));
+    return true;
+  }
+
+  bool try_pop(T &value) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+      return false;
+    value = take(h);
+    return true;
+  }
+
+  void push(T value) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    for (size_t h; t - (h = head.load(std::memory_order_acquire)) ==
+                   slots.size();)
+      head.wait(h, std::memory_order_acquire);
+    publish(t, std::move(value));
+  }
+
+  T pop() {
+    size_t h = head.load(std::memory_order_relaxed);
+    for (size_t t; h == (t = tail.load(std::memory_order_acquire));)
+      tail.wait(t, std::memory_order_acquire);
+    return take(h);
+  }
+
+private:
+  void publish(size_t t, T value) {
+    slots[t & mask] = std::move(value);
+    tail.store(t + 1, std::memory_order_release);
+    tail.notify_one();
+  }
+
+  T take(size_t h) {
+    T value = std::move(slots[h & mask]);
+    head.store(h + 1, std::memory_order_release);
+    head.notify_one();
+    return value;
+  }
+
+  std::vector<T> slots;
+  size_t mask;
+  alignas(64) std::atomic<size_t> head{0}; // next slot to pop
+  alignas(64) std::atomic<size_t> tail{0}; // next slot to push
+};
+
+} // namespace aoc
@@ -0,0 +1,149 @@
+#include "thread_pool.hpp"
+#include <utility>
+
+namespace aoc {
+
+namespace {
+thread_local ThreadPool *current_pool = nullptr;
+thread_local int current_worker = -1;
+} // namespace
+
+ThreadPool::ThreadPool(int threads) {
+  for (int i = 0; i < threads; ++i)
+    queues.push_back(std::make_unique<Queue>());
+  for (int i = 0; i < threads; ++i)
+    workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(sleep_mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+}
+
+ThreadPool *ThreadPool::current() { return current_pool; }
+
+void ThreadPool::submit(std::function<void()> task) {
+  int q = current_pool == this ? current_worker
+                               : next.fetch_add(1) % queues.size();
+  {
+    std::lock_guard lock(queues[q]->mutex);
+    queues[q]->tasks.push_back(std::move(task));
+  }
+  {
+    // Taking the lock orders the increment with a worker's check before it
+    // goes to sleep, so the wakeup can't be lost
+    std::lock_guard lock(sleep_mutex);
+    pending++;
+  }
+  wake.notify_one();
+}
+
+bool ThreadPool::pop(int self, std::function<void()> &task) {
+  if (pending.load() == 0)
+    return false;
+  int n = queues.size();
+  for (int i = 0; i < n; ++i) {
+    int q = (self + i) % n;
+    std::lock_guard lock(queues[q]->mutex);
+    auto &tasks = queues[q]->tasks;
+    if (tasks.empty())
+      continue;
+    // Newest first from our own deque (still hot in cache), oldest first
+    // when stealing (likely the biggest piece of work left)
+    if (q == self) {
+      task = std::move(tasks.back());
+      tasks.pop_back();
+    } else {
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    pending--;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::work(int self) {
+  current_pool = this;
+  current_worker = self;
+  std::function<void()> task;
+  while (true) {
+    if (pop(self, task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock lock(sleep_mutex);
+    wake.wait(lock, [&] { return stopping || pending.load() > 0; });
+    if (stopping && pending.load() == 0)
+      return;
+  }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+  {
+    std::lock_guard lock(state->mutex);
+    state->tasks.push_back(std::move(task));
+    state->remaining++;
+  }
+  state->changed.notify_all();
+  // Whoever gets there first runs it, a worker or the group's waiter; the
+  // handle that comes second finds the queue empty
+  pool.submit([state = state] { run_next(*state); });
+}
+
+bool TaskGroup::run_next(State &state) {
+  std::function<void()> task;
+  {
+    std::lock_guard lock(state.mutex);
+    if (state.tasks.empty())
+      return false;
+    task = std::move(state.tasks.front());
+    state.tasks.pop_front();
+  }
+  std::exception_ptr error;
+  try {
+    task();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  {
+    std::lock_guard lock(state.mutex);
+    if (error && !state.error)
+      state.error = error;
+    state.remaining--;
+  }
+  state.changed.notify_all();
+  return true;
+}
+
+void TaskGroup::wait() {
+  finish();
+  std::lock_guard lock(state->mutex);
+  if (state->error)
+    std::rethrow_exception(std::exchange(state->error, nullptr));
+}
+
+// A worker only helps with this group's tasks, so the ones it waits for are
+// either queued here or running on other threads, and it can safely sleep
+// until they finish. Outside the pool we never run tasks, just sleep.
+void TaskGroup::finish() {
+  bool helps = ThreadPool::current() == &pool;
+  std::unique_lock lock(state->mutex);
+  while (state->remaining > 0) {
+    if (helps && !state->tasks.empty()) {
+      lock.unlock();
+      run_next(*state);
+      lock.lock();
+      continue;
+    }
+    state->changed.wait(lock);
+  }
+}
+
+} // namespace aoc
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aoc {
+
+/**
+ * @brief Work-stealing thread pool.
+ * Every worker owns a deque: it pushes and pops its own tasks at the back and
+ * steals from the front of the others' when it runs dry. Tasks submitted from
+ * outside the pool are spread round-robin.
+ */
+class ThreadPool {
+public:
+  explicit ThreadPool(int threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(std::function<void()> task);
+
+  int size() const { return workers.size(); }
+
+  /**
+   * @brief The pool the calling thread is a worker of, or nullptr.
+   */
+  static ThreadPool *current();
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool pop(int self, std::function<void()> &task);
+  void work(int self);
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<size_t> pending{0}; // tasks queued but not taken yet
+  std::atomic<size_t> next{0};    // round-robin for outside submissions
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  bool stopping = false; // guarded by sleep_mutex
+};
+
+/**
+ * @brief A batch of tasks on a pool that can be waited on.
+ * The tasks sit in the group's own queue and the pool only gets a handle to
+ * run the next one, so a worker waiting on the group can run them itself:
+ * tasks can wait on nested groups without starving the pool, and never pick
+ * up unrelated work while they do. Any other thread just blocks.
+ * An exception thrown by a task is kept, the other tasks still run, and the
+ * first one is rethrown by wait().
+ */
+class TaskGroup {
+public:
+  explicit TaskGroup(ThreadPool &pool) : pool(pool) {}
+  ~TaskGroup() { finish(); } // drops the exception if wait() wasn't called
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  void run(std::function<void()> task);
+  void wait();
+
+private:
+  // Shared with the handles on the pool, which can outlive the group
+  struct State {
+    std::mutex mutex;
+    std::condition_variable changed; // a task was added or finished
+    std::deque<std::function<void()>> tasks; // not started yet
+    int remaining = 0;                       // not finished yet
+    std::exception_ptr error;                // first task that threw
+  };
+
+  // Runs the group's next task, false if they've all been started
+  static bool run_next(State &state);
+  void finish(); // wait() without the rethrow
+
+  ThreadPool &pool;
+  std::shared_ptr<State> state = std::make_shared<State>();
+};
+
+} // namespace aoc